@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+
+void arena_init(arena_t *arena)
+{
+	arena->blocks = NULL;
+	arena->allocated = 0;
+}
+
+void *arena_alloc(arena_t *arena, size_t size)
+{
+	arena_block_t *block = arena->blocks;
+
+	size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+	if (!block || block->used + size > block->size) {
+		/* Small trees stay in small blocks, big ones get fewer blocks */
+		size_t block_size = block ? 2 * block->size : ARENA_MIN_BLOCK;
+
+		if (block_size > ARENA_MAX_BLOCK)
+			block_size = ARENA_MAX_BLOCK;
+		while (block_size < size)
+			block_size *= 2;
+
+		block = malloc(sizeof(*block) + block_size);
+		DIE(!block, "malloc arena block failed");
+		block->next = arena->blocks;
+		block->size = block_size;
+		block->used = 0;
+		arena->blocks = block;
+		arena->allocated += block_size;
+	}
+
+	void *memory = (unsigned char *)block->data + block->used;
+
+	block->used += size;
+	memset(memory, 0, size);
+
+	return memory;
+}
+
+char *arena_strdup(arena_t *arena, const char *str)
+{
+	size_t length = strlen(str) + 1;
+	char *copy = arena_alloc(arena, length);
+
+	memcpy(copy, str, length);
+
+	return copy;
+}
+
+void arena_release(arena_t *arena)
+{
+	while (arena->blocks) {
+		arena_block_t *block = arena->blocks;
+
+		arena->blocks = block->next;
+		free(block);
+	}
+	arena->allocated = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define DIE(condition, message) \
+	do { \
+		if (condition) { \
+			fprintf(stderr, "%s\n", message); \
+			exit(EXIT_FAILURE); \
+		} \
+	} while (0)
+
+/* Every allocation is rounded up to this, which keeps them all aligned */
+#define ARENA_ALIGN sizeof(max_align_t)
+/* Size of the first block of an arena; the next ones double up to the max */
+#define ARENA_MIN_BLOCK 512
+#define ARENA_MAX_BLOCK (64 * 1024)
+
+typedef struct arena_block_t arena_block_t;
+typedef struct arena_t arena_t;
+
+/**
+ * @struct arena_block_t
+ * @brief One block of memory of an arena.
+ */
+struct arena_block_t
+{
+	arena_block_t *next; /* The previous block of the arena. */
+	size_t size; /* Number of bytes in data. */
+	size_t used; /* Number of bytes of data handed out. */
+	max_align_t data[]; /* The memory, aligned for any type. */
+};
+
+/**
+ * @struct arena_t
+ * @brief Region allocator: memory is handed out by bumping a pointer in
+ * the current block and is only given back all at once, by
+ * arena_release(). A new block is allocated when the current one is full.
+ */
+struct arena_t
+{
+	arena_block_t *blocks; /* The current block, linked to the older ones. */
+	size_t allocated; /* Total size of the blocks, in bytes. */
+};
+
+/**
+ * Initializes an empty arena. No memory is allocated until the first
+ * allocation.
+ *
+ * @param arena - The arena.
+ */
+void arena_init(arena_t *arena);
+
+/**
+ * Allocates zeroed memory from the arena.
+ *
+ * @param arena - The arena.
+ * @param size - The number of bytes.
+ * @return The memory, aligned to ARENA_ALIGN. It stays valid until the
+ * arena is released.
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Copies a string into the arena.
+ *
+ * @param arena - The arena.
+ * @param str - The string.
+ * @return The copy.
+ */
+char *arena_strdup(arena_t *arena, const char *str);
+
+/**
+ * Frees every block of the arena at once. The arena is empty afterwards
+ * and can be used again.
+ *
+ * @param arena - The arena.
+ */
+void arena_release(arena_t *arena);
+
+#endif /* ARENA_H */
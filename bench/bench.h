@@ -0,0 +1,31 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief Returns a monotonic timestamp in seconds.
+ */
+static inline double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Prints one result line of a benchmark.
+ *
+ * @param name The name of the measured operation.
+ * @param ops The number of operations that were timed.
+ * @param seconds The total time spent on those operations.
+ */
+static inline void bench_report(const char *name, long ops, double seconds)
+{
+	fprintf(stderr, "%-40s %10ld ops %10.3f ms %10.1f ns/op\n",
+			name, ops, seconds * 1e3, ops ? seconds * 1e9 / ops : 0.0);
+}
+
+#endif /* BENCH_H */
@@ -0,0 +1,126 @@
+/**
+ * Single-source vs bidirectional BFS benchmark for the distance command.
+ * The single-source version is the algorithm min_path() used before: a full
+ * BFS from src over a queue_t, read at dest once the queue is empty.
+ *
+ * Usage: ./bench/bench_bfs [chain_length] [random_nodes]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../graph.h"
+#include "../queue.h"
+#include "bench.h"
+
+#define QUERIES 50
+
+static int single_source_path(list_graph_t *graph, int src, int dest)
+{
+	int *distance = malloc(graph->nodes * sizeof(int));
+	queue_t *q = q_create(sizeof(int), graph->nodes);
+
+	DIE(!distance, "malloc failed");
+	for (int i = 0; i < graph->nodes; i++)
+		distance[i] = -1;
+
+	distance[src] = 0;
+	q_enqueue(q, &src);
+
+	while (!q_is_empty(q)) {
+		int current_node = *(int *)q_front(q);
+		int degree;
+		const int *neighbours;
+
+		q_dequeue(q);
+		neighbours = lg_neighbours(graph, current_node, &degree);
+		for (int i = 0; i < degree; i++) {
+			if (distance[neighbours[i]] == -1) {
+				distance[neighbours[i]] = distance[current_node] + 1;
+				q_enqueue(q, (void *)&neighbours[i]);
+			}
+		}
+	}
+
+	int path_length = src == dest ? -1 : distance[dest];
+
+	free(distance);
+	q_free(q);
+	return path_length;
+}
+
+static void add_friendship(list_graph_t *graph, int a, int b)
+{
+	lg_add_edge(graph, a, b);
+	lg_add_edge(graph, b, a);
+}
+
+static void compare(const char *name, list_graph_t *graph, int *src,
+					int *dest)
+{
+	char label[64];
+	int expected[QUERIES];
+	double start;
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++)
+		expected[i] = single_source_path(graph, src[i], dest[i]);
+	sprintf(label, "%s, single-source bfs", name);
+	bench_report(label, QUERIES, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++)
+		DIE(min_path(graph, src[i], dest[i]) != expected[i],
+			"min_path disagrees with the single-source bfs");
+	sprintf(label, "%s, bidirectional bfs", name);
+	bench_report(label, QUERIES, bench_now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+	int length = argc > 1 ? atoi(argv[1]) : 100000;
+	int nodes = argc > 2 ? atoi(argv[2]) : 200000;
+	int src[QUERIES], dest[QUERIES];
+
+	/* A long chain where every link also has two leaves hanging off it */
+	list_graph_t *chain = lg_create(3 * length);
+
+	for (int i = 0; i < length; i++) {
+		if (i + 1 < length)
+			add_friendship(chain, i, i + 1);
+		add_friendship(chain, i, length + 2 * i);
+		add_friendship(chain, i, length + 2 * i + 1);
+	}
+	lg_build_csr(chain);
+
+	srand(3);
+	for (int i = 0; i < QUERIES; i++) {
+		src[i] = rand() % length;
+		dest[i] = src[i] + 1 + rand() % 64 < length ?
+				  src[i] + 1 + rand() % 64 : 0;
+	}
+	compare("chain, close pairs", chain, src, dest);
+
+	for (int i = 0; i < QUERIES; i++) {
+		src[i] = i;
+		dest[i] = length - 1 - i;
+	}
+	compare("chain, end to end", chain, src, dest);
+	lg_free(chain);
+
+	/* A sparse random graph with an average degree of 8 */
+	list_graph_t *random = lg_create(nodes);
+
+	for (long i = 0; i < 4L * nodes; i++)
+		add_friendship(random, rand() % nodes, rand() % nodes);
+	lg_build_csr(random);
+
+	for (int i = 0; i < QUERIES; i++) {
+		src[i] = rand() % nodes;
+		dest[i] = rand() % nodes;
+	}
+	compare("random", random, src, dest);
+	lg_free(random);
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+/**
+ * Memory per repost of a big repost cascade. Every repost reposts a random
+ * earlier repost (or the post) and gets one like, so most reposts are
+ * leaves, like in real cascades. Reports the growth of the resident set size
+ * (RSS) per repost and the bytes the tree accounts for per node, split by
+ * structure. For comparison, it then allocates one fixed array of 100 child
+ * pointers per repost, which is what every node carried before the child
+ * arrays grew on demand.
+ * The cascade is built in a tree with an arena (like the posts) and in a
+ * tree that allocates every node, info, title and like with malloc, and the
+ * time to delete the whole post is measured for both.
+ *
+ * Usage: ./bench/bench_cascade [reposts]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../posts.h"
+#include "bench.h"
+
+/* Child slots of every node before the child arrays became growable */
+#define OLD_CHILDREN 100
+
+static long resident_bytes(void)
+{
+	long pages = 0, resident = 0;
+	FILE *statm = fopen("/proc/self/statm", "r");
+
+	if (!statm)
+		return 0;
+	if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+		resident = 0;
+	fclose(statm);
+
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+typedef struct {
+	size_t nodes, children, jumps, data;
+} tree_memory;
+
+static void account(g_node_t *node, tree_memory *memory)
+{
+	memory->nodes += sizeof(*node);
+	memory->children += node->children_capacity * sizeof(*node->children);
+	memory->jumps += node->n_jumps * sizeof(*node->jump);
+	like_set_t *likes = &((info *)node->data)->likes;
+
+	memory->data += sizeof(info);
+	if (likes->is_hash)
+		memory->data += likes->capacity * sizeof(*likes->slots);
+	else
+		memory->data += likes->capacity * sizeof(*likes->bitmap);
+
+	for (int i = 0; i < node->n_children; i++)
+		account(node->children[i], memory);
+}
+
+static void report_bytes(const char *name, double bytes, int reposts)
+{
+	fprintf(stderr, "%-40s %10.1f bytes/repost\n", name, bytes / reposts);
+}
+
+/* Builds the cascade in tree, returns the time spent in insert_node() */
+static double build_cascade(g_tree_t *tree, int reposts, int *ids)
+{
+	info *data = create_info(tree, 1, 0, "cascade");
+	double start, elapsed = 0;
+
+	insert_node(tree, data, 0);
+	free(data);
+	ids[0] = 1;
+
+	for (int i = 1; i <= reposts; i++) {
+		data = create_info(tree, i + 1, 0, NULL);
+		start = bench_now();
+		insert_node(tree, data, ids[rand() % i]);
+		elapsed += bench_now() - start;
+		free(data);
+		ids[i] = i + 1;
+
+		ls_toggle(&((info *)search_node(tree, i + 1)->data)->likes, i);
+	}
+
+	return elapsed;
+}
+
+int main(int argc, char **argv)
+{
+	int reposts = argc > 1 ? atoi(argv[1]) : 1000000;
+	int *ids = malloc((reposts + 1) * sizeof(*ids));
+	tree_memory memory = {0};
+	double start;
+
+	DIE(!ids, "malloc failed");
+	srand(13);
+
+	long rss = resident_bytes();
+	g_tree_t *tree = init_generic_tree_in_arena(sizeof(info), 0);
+
+	bench_report("arena cascade, insert", reposts,
+				 build_cascade(tree, reposts, ids));
+	report_bytes("arena cascade, rss growth", resident_bytes() - rss,
+				 reposts);
+	account(tree->root, &memory);
+	report_bytes("  g_node_t", memory.nodes, reposts);
+	report_bytes("  child arrays", memory.children, reposts);
+	report_bytes("  jump tables", memory.jumps, reposts);
+	report_bytes("  info and like set", memory.data, reposts);
+
+	rss = resident_bytes();
+	g_node_t ***old_children = malloc(reposts * sizeof(*old_children));
+
+	DIE(!old_children, "malloc failed");
+	for (int i = 0; i < reposts; i++) {
+		old_children[i] = calloc(OLD_CHILDREN, sizeof(g_node_t *));
+		DIE(!old_children[i], "calloc failed");
+	}
+	report_bytes("fixed child arrays alone, rss growth",
+				 resident_bytes() - rss, reposts);
+	for (int i = 0; i < reposts; i++)
+		free(old_children[i]);
+	free(old_children);
+
+	start = bench_now();
+	free_g_tree(tree);
+	bench_report("arena cascade, delete post", reposts + 1,
+				 bench_now() - start);
+
+	/* The ids of the freed tree are stale, so they can be added again */
+	tree = init_generic_tree(sizeof(info), free_value_post, 0);
+	bench_report("malloc cascade, insert", reposts,
+				 build_cascade(tree, reposts, ids));
+	start = bench_now();
+	free_g_tree(tree);
+	bench_report("malloc cascade, delete post", reposts + 1,
+				 bench_now() - start);
+
+	free_g_index();
+	free(ids);
+
+	return 0;
+}
@@ -0,0 +1,421 @@
+/**
+ * Benchmark of the feed commands on a random friendship graph (100k users
+ * with 16 friends each by default) where random users created 1M posts and
+ * 1M reposts of HOT_POSTS of them. The feed is timed in pull mode (merge of
+ * the lists of posts of the authors) and in push mode (timelines), with the
+ * cost of keeping the timelines up to date, then in push and hybrid mode
+ * once CELEBRITIES users have thousands of friends, and with the cache of
+ * the last feed of every user on a repeated poll. Every view-profile goes
+ * through the lists of posts and reposts of the users, and friends-repost
+ * through the set of reposters of the post; the previous scans over the
+ * whole table of posts and walks over the repost trees are kept here as the
+ * baseline. With at most LG_BITSET_MAX_NODES users, friends-repost ANDs the
+ * bitsets of the friends and of the reposters instead.
+ *
+ * Usage: ./bench/bench_feed [users] [posts] [feed_size] [reposts]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../feed.h"
+#include "../timeline.h"
+#include "bench.h"
+
+#define DEGREE 16
+#define QUERIES 1000
+/* Every old view-profile reads all the posts, so it gets fewer queries */
+#define SCAN_QUERIES 20
+/* The reposts go to the first HOT_POSTS posts */
+#define HOT_POSTS 100
+/* Users 0 .. CELEBRITIES - 1 get about CELEBRITY_FRIENDS more friends */
+#define CELEBRITIES 10
+#define CELEBRITY_FRIENDS 5000
+
+static void user_name(char *buf, unsigned int id)
+{
+	sprintf(buf, "u%u", id);
+}
+
+/* feed() before the lists of posts of the authors */
+static void legacy_feed(list_graph_t *graph, tree_post_manager *post_manager,
+						int user_id, int feed_size)
+{
+	int n_friends;
+	const int *friends = lg_neighbours(graph, user_id, &n_friends);
+	query_workspace_t *ws = ws_acquire(graph->nodes);
+
+	for (int i = 0; i < n_friends; i++)
+		ws_set(ws, friends[i], 1);
+	ws_set(ws, user_id, 1);
+
+	for (int i = post_manager->n_posts - 1; i >= 0 && feed_size > 0; i--) {
+		if (!post_manager->posts[i])
+			continue;
+		info *data = post_manager->posts[i]->root->data;
+
+		if (ws_get(ws, data->user_id) == 1) {
+			printf("%s: %s\n", get_user_name(data->user_id), data->title);
+			feed_size--;
+		}
+	}
+}
+
+/* The "Posted:" half of view_profile() before the lists of posts */
+static void legacy_posted(tree_post_manager *post_manager, int user_id)
+{
+	for (int i = 0; i < post_manager->n_posts; i++) {
+		if (!post_manager->posts[i])
+			continue;
+		info *data = post_manager->posts[i]->root->data;
+
+		if (data->user_id == user_id)
+			printf("Posted: %s\n", data->title);
+	}
+}
+
+typedef struct {
+	int user_id; /* User whose reposts are printed. */
+	char *title; /* Title of the original post. */
+} reposts_walk_t;
+
+static int reposts_visit(g_node_t *node, int level, void *arg)
+{
+	reposts_walk_t *walk = arg;
+
+	if (level != 0 && ((info *)node->data)->user_id == walk->user_id)
+		printf("Reposted: %s\n", walk->title);
+	return 0;
+}
+
+/* The "Reposted:" half of view_profile() before the lists of reposts */
+static void legacy_reposted(tree_post_manager *post_manager, int user_id)
+{
+	for (int i = 0; i < post_manager->n_posts; i++) {
+		g_node_t *root = post_manager->posts[i]->root;
+		reposts_walk_t walk = {user_id, ((info *)root->data)->title};
+
+		g_tree_walk(root, reposts_visit, NULL, &walk);
+	}
+}
+
+static int friends_visit(g_node_t *node, int level, void *arg)
+{
+	query_workspace_t *ws = arg;
+	int user_id = ((info *)node->data)->user_id;
+
+	if (level != 0 && ws_get(ws, user_id) == 1)
+		ws_set(ws, user_id, 2);
+	return 0;
+}
+
+/* friends_repost() before the sets of reposters: marks the friends in ws */
+static void legacy_friends_repost(list_graph_t *graph, g_node_t *root,
+								  int user_id)
+{
+	int n_friends;
+	const int *friends = lg_neighbours(graph, user_id, &n_friends);
+	query_workspace_t *ws = ws_acquire(graph->nodes);
+
+	for (int i = 0; i < n_friends; i++)
+		ws_set(ws, friends[i], 1);
+	g_tree_walk(root, friends_visit, NULL, ws);
+}
+
+/* Registers the users and gives every one about DEGREE random friends */
+static list_graph_t *build_graph(int users)
+{
+	char name[32];
+
+	for (int i = 0; i < users; i++) {
+		user_name(name, i);
+		register_user(name);
+	}
+
+	list_graph_t *graph = lg_create(users);
+
+	for (int i = 0; i < users; i++) {
+		for (int j = 0; j < DEGREE / 2; j++) {
+			int friend = rand() % users;
+
+			if (friend != i && lg_add_edge(graph, i, friend))
+				lg_add_edge(graph, friend, i);
+		}
+	}
+	return graph;
+}
+
+static void bench_queries(list_graph_t *graph,
+						  tree_post_manager *post_manager,
+						  const int *queries, int feed_size)
+{
+	char name[32];
+	double start;
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++)
+		legacy_feed(graph, post_manager, queries[i], feed_size);
+	bench_report("feed, scan of all posts", QUERIES, bench_now() - start);
+
+	feed_set_mode(FEED_PULL);
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+	bench_report("feed, pull (merge of author lists)", QUERIES,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < SCAN_QUERIES; i++)
+		legacy_posted(post_manager, queries[i]);
+	bench_report("posted, scan of all posts", SCAN_QUERIES,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		int n_posts;
+		const int *own = get_author_posts(post_manager, queries[i],
+										  &n_posts);
+
+		for (int j = 0; j < n_posts; j++) {
+			info *data = search_g_tree(post_manager, own[j])->root->data;
+
+			printf("Posted: %s\n", data->title);
+		}
+	}
+	bench_report("posted, author list", QUERIES, bench_now() - start);
+}
+
+/* Times the push mode: building the timelines, reading and updating them */
+static void bench_push(list_graph_t *graph, tree_post_manager *post_manager,
+					   const int *queries, int users, int feed_size)
+{
+	char name[32];
+	double start;
+
+	feed_set_mode(FEED_PUSH);
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+	bench_report("feed, push, first read (build)", QUERIES,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+	bench_report("feed, push (timeline)", QUERIES, bench_now() - start);
+
+	/* Every new post goes to the timelines of the author and friends */
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[rand() % QUERIES]);
+		create_post(post_manager, name, "post");
+		feed_post_created(graph, post_manager, post_manager->id_counter - 1);
+	}
+	bench_report("create, push fan-out", QUERIES, bench_now() - start);
+
+	/* A new friend backfills the timeline, removing them evicts it */
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		int friend = rand() % users;
+
+		if (friend == queries[i] || !lg_add_edge(graph, queries[i], friend))
+			continue;
+		lg_add_edge(graph, friend, queries[i]);
+		feed_friendship_changed(graph, post_manager, queries[i], friend);
+		lg_remove_edge(graph, queries[i], friend);
+		lg_remove_edge(graph, friend, queries[i]);
+		feed_friendship_changed(graph, post_manager, queries[i], friend);
+	}
+	bench_report("add + remove, push backfill/evict", QUERIES,
+				 bench_now() - start);
+}
+
+/* Times the reads and the posts of the celebrities in the given mode */
+static void bench_celebrities(list_graph_t *graph,
+							  tree_post_manager *post_manager,
+							  const int *queries, int feed_size, int mode)
+{
+	const char *label = mode == FEED_HYBRID ? "hybrid" : "push";
+	char name[32], line[64];
+	feed_stats stats;
+	double start;
+
+	feed_set_mode(mode);
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+
+	reset_feed_stats();
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+	get_feed_stats(&stats);
+	sprintf(line, "feed, %s, %.1f lists merged", label,
+			(double)stats.merged / QUERIES);
+	bench_report(line, QUERIES, bench_now() - start);
+
+	reset_feed_stats();
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, i % CELEBRITIES);
+		create_post(post_manager, name, "post");
+		feed_post_created(graph, post_manager, post_manager->id_counter - 1);
+	}
+	get_feed_stats(&stats);
+	sprintf(line, "create, celebrity, %s, %.0f pushed", label,
+			(double)stats.fanout / QUERIES);
+	bench_report(line, QUERIES, bench_now() - start);
+}
+
+/* Gives the celebrities their friends and compares push and hybrid mode */
+static void bench_hybrid(list_graph_t *graph, tree_post_manager *post_manager,
+						 const int *queries, int users, int feed_size)
+{
+	for (int i = 0; i < CELEBRITIES; i++) {
+		for (int j = 0; j < CELEBRITY_FRIENDS; j++) {
+			int friend = rand() % users;
+
+			if (friend != i && lg_add_edge(graph, i, friend))
+				lg_add_edge(graph, friend, i);
+		}
+	}
+
+	feed_set_celebrity_degree(CELEBRITY_FRIENDS / 2);
+	bench_celebrities(graph, post_manager, queries, feed_size, FEED_PUSH);
+	bench_celebrities(graph, post_manager, queries, feed_size, FEED_HYBRID);
+}
+
+/* Times a repeated poll of the same feeds, served by the cache */
+static void bench_cache(list_graph_t *graph, tree_post_manager *post_manager,
+						const int *queries, int feed_size)
+{
+	char name[32], line[64];
+	feed_stats stats;
+	double start;
+
+	feed_set_cache(1);
+	reset_feed_stats();
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+	bench_report("feed, hybrid, first poll (cache miss)", QUERIES,
+				 bench_now() - start);
+
+	reset_feed_stats();
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		feed(graph, post_manager, name, feed_size);
+	}
+	get_feed_stats(&stats);
+	sprintf(line, "feed, hybrid, repeated poll, %lu hits", stats.cache_hits);
+	bench_report(line, QUERIES, bench_now() - start);
+	feed_set_cache(0);
+}
+
+static void bench_reposts(list_graph_t *graph,
+						  tree_post_manager *post_manager, const int *queries)
+{
+	char name[32];
+	double start;
+
+	start = bench_now();
+	for (int i = 0; i < SCAN_QUERIES; i++)
+		legacy_reposted(post_manager, queries[i]);
+	bench_report("reposted, walk of all trees", SCAN_QUERIES,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		int n_reposts;
+		const repost_entry_t *reposts =
+		get_user_reposts(post_manager, queries[i], &n_reposts);
+
+		for (int j = 0; j < n_reposts; j++) {
+			info *data = search_g_tree(post_manager,
+									   reposts[j].post_id)->root->data;
+
+			printf("Reposted: %s\n", data->title);
+		}
+	}
+	bench_report("reposted, repost list", QUERIES, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++)
+		legacy_friends_repost(graph, post_manager->posts[i % HOT_POSTS]->root,
+							  queries[i]);
+	bench_report("friends-repost, walk of the tree", QUERIES,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name, queries[i]);
+		friends_repost(graph, post_manager, name, i % HOT_POSTS + 1);
+	}
+	bench_report("friends-repost, reposter set", QUERIES,
+				 bench_now() - start);
+}
+
+int main(int argc, char **argv)
+{
+	int users = argc > 1 ? atoi(argv[1]) : 100000;
+	int posts = argc > 2 ? atoi(argv[2]) : 1000000;
+	int feed_size = argc > 3 ? atoi(argv[3]) : 10;
+	int reposts = argc > 4 ? atoi(argv[4]) : 1000000;
+	char name[32];
+	double start;
+
+	DIE(!freopen("/dev/null", "w", stdout), "freopen failed");
+	srand(20);
+	/* Every mode is timed on feeds that are built, not cached */
+	feed_set_cache(0);
+
+	list_graph_t *graph = build_graph(users);
+	tree_post_manager *post_manager = create_post_manager();
+
+	start = bench_now();
+	for (int i = 0; i < posts; i++) {
+		user_name(name, rand() % users);
+		create_post(post_manager, name, "post");
+	}
+	bench_report("create", posts, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < reposts; i++) {
+		user_name(name, rand() % users);
+		create_repost(post_manager, name, i % HOT_POSTS + 1, 0);
+	}
+	bench_report("repost", reposts, bench_now() - start);
+
+	int *queries = malloc(QUERIES * sizeof(int));
+
+	DIE(!queries, "malloc failed");
+	for (int i = 0; i < QUERIES; i++)
+		queries[i] = rand() % users;
+	bench_queries(graph, post_manager, queries, feed_size);
+	bench_push(graph, post_manager, queries, users, feed_size);
+	bench_hybrid(graph, post_manager, queries, users, feed_size);
+	bench_cache(graph, post_manager, queries, feed_size);
+	bench_reposts(graph, post_manager, queries);
+
+	free(queries);
+	free_post_manager(post_manager);
+	lg_free(graph);
+	free_g_index();
+	ws_free();
+	tl_free();
+	free_users();
+
+	return 0;
+}
@@ -0,0 +1,227 @@
+/**
+ * Adjacency layout benchmark.
+ * Builds a power-law (preferential attachment) friendship graph and runs
+ * the same neighbour walks and BFS traversals over linked lists (the
+ * layout the graph used to have, rebuilt here from the graph), over the
+ * sorted per-node adjacency arrays and over the CSR snapshot returned by
+ * lg_neighbours().
+ *
+ * Usage: ./bench/bench_graph [nodes] [edges_per_node]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../graph.h"
+#include "../linked_list.h"
+#include "bench.h"
+
+#define BFS_SOURCES 20
+
+static void build_power_law(list_graph_t *graph, int nodes, int m)
+{
+	/* Every edge endpoint, so picking a random entry is degree biased */
+	int *endpoints = malloc(2L * nodes * m * sizeof(int));
+	long n_endpoints = 0;
+
+	DIE(!endpoints, "malloc failed");
+	srand(7);
+
+	for (int v = 1; v < nodes; v++) {
+		for (int k = 0; k < m && k < v; k++) {
+			int u = n_endpoints ? endpoints[rand() % n_endpoints] : 0;
+
+			if (u == v || lg_has_edge(graph, v, u))
+				u = rand() % v;
+			if (lg_has_edge(graph, v, u))
+				continue;
+
+			lg_add_edge(graph, v, u);
+			lg_add_edge(graph, u, v);
+			endpoints[n_endpoints++] = u;
+			endpoints[n_endpoints++] = v;
+		}
+	}
+
+	free(endpoints);
+}
+
+static linked_list_t **build_lists(list_graph_t *graph)
+{
+	linked_list_t **lists = malloc(graph->nodes * sizeof(*lists));
+
+	DIE(!lists, "malloc failed");
+	for (int v = 0; v < graph->nodes; v++) {
+		lists[v] = ll_create(sizeof(int));
+		for (unsigned int i = 0; i < graph->neighbors[v].size; i++)
+			ll_add_nth_node(lists[v], lists[v]->size,
+							&graph->neighbors[v].data[i]);
+	}
+
+	return lists;
+}
+
+static long walk_lists(list_graph_t *graph, linked_list_t **lists)
+{
+	long sum = 0;
+
+	for (int v = 0; v < graph->nodes; v++)
+		for (ll_node_t *n = lists[v]->head; n; n = n->next)
+			sum += *(int *)n->data;
+
+	return sum;
+}
+
+static long walk_arrays(list_graph_t *graph)
+{
+	long sum = 0;
+
+	for (int v = 0; v < graph->nodes; v++)
+		for (unsigned int i = 0; i < graph->neighbors[v].size; i++)
+			sum += graph->neighbors[v].data[i];
+
+	return sum;
+}
+
+static long walk_csr(list_graph_t *graph)
+{
+	long sum = 0;
+
+	for (int v = 0; v < graph->nodes; v++) {
+		int degree;
+		const int *neighbours = lg_neighbours(graph, v, &degree);
+
+		for (int i = 0; i < degree; i++)
+			sum += neighbours[i];
+	}
+
+	return sum;
+}
+
+static long bfs_lists(list_graph_t *graph, linked_list_t **lists, int src,
+					  int *dist, int *queue)
+{
+	int head = 0, tail = 0;
+	long reached = 0;
+
+	memset(dist, -1, graph->nodes * sizeof(int));
+	dist[src] = 0;
+	queue[tail++] = src;
+
+	while (head < tail) {
+		int v = queue[head++];
+
+		reached++;
+		for (ll_node_t *n = lists[v]->head; n; n = n->next) {
+			int u = *(int *)n->data;
+
+			if (dist[u] < 0) {
+				dist[u] = dist[v] + 1;
+				queue[tail++] = u;
+			}
+		}
+	}
+
+	return reached;
+}
+
+static long bfs_csr(list_graph_t *graph, int src, int *dist, int *queue)
+{
+	int head = 0, tail = 0;
+	long reached = 0;
+
+	memset(dist, -1, graph->nodes * sizeof(int));
+	dist[src] = 0;
+	queue[tail++] = src;
+
+	while (head < tail) {
+		int v = queue[head++];
+		int degree;
+		const int *neighbours = lg_neighbours(graph, v, &degree);
+
+		reached++;
+		for (int i = 0; i < degree; i++) {
+			int u = neighbours[i];
+
+			if (dist[u] < 0) {
+				dist[u] = dist[v] + 1;
+				queue[tail++] = u;
+			}
+		}
+	}
+
+	return reached;
+}
+
+int main(int argc, char *argv[])
+{
+	int nodes = argc > 1 ? atoi(argv[1]) : 100000;
+	int m = argc > 2 ? atoi(argv[2]) : 5;
+	list_graph_t *graph = lg_create(nodes);
+	int *dist = malloc(nodes * sizeof(int));
+	int *queue = malloc(nodes * sizeof(int));
+	double start;
+	long walk[3] = {0}, reached[2] = {0}, hits = 0;
+
+	DIE(!dist || !queue, "malloc failed");
+
+	start = bench_now();
+	build_power_law(graph, nodes, m);
+	bench_report("build (add edges)", nodes, bench_now() - start);
+
+	start = bench_now();
+	lg_build_csr(graph);
+	bench_report("csr rebuild", nodes, bench_now() - start);
+
+	linked_list_t **lists = build_lists(graph);
+
+	start = bench_now();
+	for (int i = 0; i < nodes; i++)
+		hits += lg_has_edge(graph, i, rand() % nodes);
+	bench_report("lg_has_edge (binary search)", nodes, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < 10; i++)
+		walk[0] += walk_lists(graph, lists);
+	bench_report("neighbour walk, lists", 10L * nodes, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < 10; i++)
+		walk[1] += walk_arrays(graph);
+	bench_report("neighbour walk, sorted arrays", 10L * nodes,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < 10; i++)
+		walk[2] += walk_csr(graph);
+	bench_report("neighbour walk, csr", 10L * nodes, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < BFS_SOURCES; i++)
+		reached[0] += bfs_lists(graph, lists, i * (nodes / BFS_SOURCES),
+								dist, queue);
+	bench_report("bfs, lists", BFS_SOURCES, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < BFS_SOURCES; i++)
+		reached[1] += bfs_csr(graph, i * (nodes / BFS_SOURCES), dist, queue);
+	bench_report("bfs, csr", BFS_SOURCES, bench_now() - start);
+
+	DIE(walk[0] != walk[1] || walk[1] != walk[2] || reached[0] != reached[1],
+		"the layouts disagree");
+
+	start = bench_now();
+	for (int i = 0; i < BFS_SOURCES; i++)
+		min_path(graph, i, nodes - 1 - i);
+	bench_report("min_path", BFS_SOURCES, bench_now() - start);
+
+	fprintf(stderr, "%ld random edge checks hit\n", hits);
+
+	for (int v = 0; v < nodes; v++)
+		ll_free(&lists[v]);
+	free(lists);
+	free(dist);
+	free(queue);
+	lg_free(graph);
+	return 0;
+}
@@ -0,0 +1,134 @@
+/**
+ * common-repost benchmark: the Euler tour rebuilt on every query (what
+ * common_repost() did before) against binary lifting over the jump tables
+ * kept by insert_node() and against the cached Euler tour with a sparse
+ * table, whose first query pays for the rebuild. Runs on a deep repost
+ * chain and on a tree where the post and each of its reposts are reposted
+ * fan_out times.
+ *
+ * Usage: ./bench/bench_lca [chain_length] [fan_out]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../posts.h"
+#include "bench.h"
+
+#define QUERIES 2000
+
+static int next_id = 1;
+
+static int add_node(g_tree_t *tree, int parent_id)
+{
+	info *data = create_info(tree, next_id, 0, parent_id ? NULL : "post");
+
+	insert_node(tree, data, parent_id);
+	free(data);
+	return next_id++;
+}
+
+static int euler_lca(g_tree_t *tree, int id_1, int id_2)
+{
+	int vector_length = 2 * count_tree_nodes(tree);
+	int *euler_vector = calloc(vector_length, sizeof(int));
+	int *level_vector = calloc(vector_length, sizeof(int));
+	int index = 0;
+
+	DIE(!euler_vector || !level_vector, "calloc failed");
+	create_euler_representation(tree->root, euler_vector, level_vector,
+								&index, 0);
+	int lca_id = search_lca(euler_vector, level_vector, id_1, id_2);
+
+	free(euler_vector);
+	free(level_vector);
+	return lca_id;
+}
+
+static int lifting_lca(g_tree_t *tree, int id_1, int id_2)
+{
+	g_node_t *lca = lowest_common_ancestor(search_node(tree, id_1),
+										   search_node(tree, id_2));
+
+	return ((info *)lca->data)->id;
+}
+
+static void compare(const char *name, g_tree_t *tree, int first_id,
+					int last_id, int queries)
+{
+	int *pairs = malloc(2 * queries * sizeof(int));
+	int *expected = malloc(queries * sizeof(int));
+	char label[64];
+	double start;
+
+	DIE(!pairs || !expected, "malloc failed");
+	for (int i = 0; i < 2 * queries; i++)
+		pairs[i] = first_id + rand() % (last_id - first_id + 1);
+
+	start = bench_now();
+	for (int i = 0; i < queries; i++)
+		expected[i] = euler_lca(tree, pairs[2 * i], pairs[2 * i + 1]);
+	sprintf(label, "%s, euler tour per query", name);
+	bench_report(label, queries, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < queries; i++)
+		DIE(lifting_lca(tree, pairs[2 * i], pairs[2 * i + 1]) != expected[i],
+			"binary lifting disagrees with the euler tour");
+	sprintf(label, "%s, binary lifting", name);
+	bench_report(label, queries, bench_now() - start);
+
+	/* The insertions left the cache dirty, so the first query rebuilds it */
+	start = bench_now();
+	for (int i = 0; i < queries; i++) {
+		g_node_t *lca = euler_cache_lca(tree, search_node(tree, pairs[2 * i]),
+										search_node(tree, pairs[2 * i + 1]));
+
+		DIE(((info *)lca->data)->id != expected[i],
+			"the euler tour cache disagrees with the euler tour");
+	}
+	sprintf(label, "%s, euler tour cache", name);
+	bench_report(label, queries, bench_now() - start);
+
+	free(pairs);
+	free(expected);
+}
+
+int main(int argc, char **argv)
+{
+	int length = argc > 1 ? atoi(argv[1]) : 20000;
+	int fan_out = argc > 2 ? atoi(argv[2]) : 100;
+	double start;
+
+	srand(11);
+
+	/* Every repost of the chain reposts the previous one */
+	g_tree_t *chain = init_generic_tree_in_arena(sizeof(info), 0);
+	int first_id = add_node(chain, 0), last_id = first_id;
+
+	start = bench_now();
+	for (int i = 1; i < length; i++)
+		last_id = add_node(chain, last_id);
+	bench_report("chain, insert with jump tables", length - 1,
+				 bench_now() - start);
+	compare("chain", chain, first_id, last_id, QUERIES / 10);
+	free_g_tree(chain);
+
+	/* Two levels of fans under the post */
+	g_tree_t *fans = init_generic_tree_in_arena(sizeof(info), 0);
+	int root_id = add_node(fans, 0);
+
+	first_id = next_id;
+	for (int i = 0; i < fan_out; i++) {
+		int child_id = add_node(fans, root_id);
+
+		for (int j = 0; j < fan_out; j++)
+			last_id = add_node(fans, child_id);
+	}
+	compare("fans", fans, first_id, last_id, QUERIES);
+	free_g_tree(fans);
+
+	free_g_index();
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * Benchmark of like/unlike toggles on a single post. Runs the toggles on a
+ * like set with a small population of users (the set stays a bitmap) and
+ * with a large one (the set becomes a hash set), and runs fewer toggles on
+ * the previous like list, which was scanned for the user on every toggle.
+ * Checks that the like count matches the set after the toggles.
+ *
+ * Usage: ./bench/bench_likes [toggles] [large_population]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../like_set.h"
+#include "../linked_list.h"
+#include "bench.h"
+
+/* Users of the small population, all kept in the bitmap */
+#define SMALL_POPULATION 512
+/* Toggles on the like list, which gets slow with many likes */
+#define LIST_TOGGLES 20000
+
+static int *random_users(long toggles, int population)
+{
+	int *users = malloc(toggles * sizeof(*users));
+
+	DIE(!users, "malloc failed");
+	for (long i = 0; i < toggles; i++)
+		users[i] = rand() % population;
+	return users;
+}
+
+static void bench_set(const char *name, long toggles, int population,
+					  arena_t *arena)
+{
+	int *users = random_users(toggles, population);
+	like_set_t likes;
+	int n_likes = 0;
+	char *liked = calloc(population, 1);
+
+	DIE(!liked, "calloc failed");
+	ls_init(&likes, arena);
+
+	double start = bench_now();
+
+	for (long i = 0; i < toggles; i++)
+		n_likes += ls_toggle(&likes, users[i]) ? 1 : -1;
+	bench_report(name, toggles, bench_now() - start);
+
+	/* The count kept by the caller and the set must agree */
+	for (long i = 0; i < toggles; i++)
+		liked[users[i]] ^= 1;
+	for (int i = 0; i < population; i++)
+		DIE(liked[i] != ls_contains(&likes, i), "like set mismatch");
+	DIE(n_likes != (int)ls_size(&likes), "like count mismatch");
+
+	if (!arena)
+		ls_free(&likes);
+	free(liked);
+	free(users);
+}
+
+/* The previous like_post: find the user in the list, then add or remove */
+static void bench_list(const char *name, long toggles, int population)
+{
+	int *users = random_users(toggles, population);
+	linked_list_t *likes = ll_create(sizeof(int));
+
+	double start = bench_now();
+
+	for (long i = 0; i < toggles; i++) {
+		ll_node_t *node = likes->head;
+		unsigned int pos = 0;
+
+		while (node && *(int *)node->data != users[i]) {
+			node = node->next;
+			pos++;
+		}
+		if (!node) {
+			ll_add_nth_node(likes, likes->size, &users[i]);
+		} else {
+			node = ll_remove_nth_node(likes, pos);
+			free(node->data);
+			free(node);
+		}
+	}
+	bench_report(name, toggles, bench_now() - start);
+
+	ll_free(&likes);
+	free(users);
+}
+
+int main(int argc, char **argv)
+{
+	long toggles = argc > 1 ? atol(argv[1]) : 1000000;
+	int population = argc > 2 ? atoi(argv[2]) : 1000000;
+	arena_t arena;
+
+	srand(17);
+
+	bench_set("bitmap set, small population", toggles, SMALL_POPULATION,
+			  NULL);
+	bench_set("hash set, large population", toggles, population, NULL);
+
+	arena_init(&arena);
+	bench_set("hash set in arena, large population", toggles, population,
+			  &arena);
+	arena_release(&arena);
+
+	bench_list("like list, small population", LIST_TOGGLES,
+			   SMALL_POPULATION);
+	bench_list("like list, large population", LIST_TOGGLES, population);
+
+	return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * Scaling benchmark for the growable user registry.
+ * For every population size it registers that many users at runtime,
+ * grows the friendship graph to match, and then times the friendship
+ * commands on a fixed cluster of users spread over the whole id range.
+ * The per-command cost should not depend on the total population.
+ *
+ * Usage: ./bench/bench_registry [population ...]
+ * (defaults to 1000000 10000000)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../users.h"
+#include "../friends.h"
+#include "bench.h"
+
+#define CLUSTER_SIZE 1000
+#define CLUSTER_DEGREE 16
+#define QUERIES 1000
+
+static void user_name(char *buf, unsigned int id)
+{
+	sprintf(buf, "u%u", id);
+}
+
+static void run_commands(list_graph_t *graph, unsigned int population)
+{
+	unsigned int stride = population / CLUSTER_SIZE;
+	char name_1[32], name_2[32];
+	double start;
+
+	srand(42);
+
+	start = bench_now();
+	for (int i = 0; i < CLUSTER_SIZE; i++) {
+		for (int j = 0; j < CLUSTER_DEGREE / 2; j++) {
+			user_name(name_1, i * stride);
+			user_name(name_2, (rand() % CLUSTER_SIZE) * stride);
+			add_friend(graph, name_1, name_2);
+		}
+	}
+	bench_report("  add", CLUSTER_SIZE * CLUSTER_DEGREE / 2,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name_1, (rand() % CLUSTER_SIZE) * stride);
+		suggestions(graph, name_1);
+	}
+	bench_report("  suggestions", QUERIES, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name_1, (rand() % CLUSTER_SIZE) * stride);
+		user_name(name_2, (rand() % CLUSTER_SIZE) * stride);
+		common_friends(graph, name_1, name_2);
+	}
+	bench_report("  common", QUERIES, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name_1, (rand() % CLUSTER_SIZE) * stride);
+		user_name(name_2, (rand() % CLUSTER_SIZE) * stride);
+		get_distance(graph, name_1, name_2);
+	}
+	bench_report("  distance", QUERIES, bench_now() - start);
+
+	start = bench_now();
+	for (int i = 0; i < QUERIES; i++) {
+		user_name(name_1, (rand() % CLUSTER_SIZE) * stride);
+		most_popular_friend(graph, name_1);
+	}
+	bench_report("  popular", QUERIES, bench_now() - start);
+}
+
+static void run_population(unsigned int population)
+{
+	char name[32];
+	double start;
+
+	fprintf(stderr, "population %u\n", population);
+
+	start = bench_now();
+	for (unsigned int i = 0; i < population; i++) {
+		user_name(name, i);
+		register_user(name);
+	}
+	bench_report("  register", population, bench_now() - start);
+
+	start = bench_now();
+	list_graph_t *graph = lg_create(0);
+
+	lg_grow(graph, get_users_number());
+	bench_report("  graph grow", population, bench_now() - start);
+
+	run_commands(graph, population);
+
+	lg_free(graph);
+	free_users();
+}
+
+int main(int argc, char *argv[])
+{
+	DIE(!freopen("/dev/null", "w", stdout), "freopen failed");
+
+	if (argc == 1) {
+		run_population(1000000);
+		run_population(10000000);
+	}
+
+	for (int i = 1; i < argc; i++)
+		run_population(atoi(argv[i]));
+
+	return 0;
+}
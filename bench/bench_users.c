@@ -0,0 +1,95 @@
+/**
+ * Startup benchmark for the users.db loader.
+ * Generates a users.db with N names (1M by default), then times the old
+ * fscanf() + malloc() per name loader against load_users_from().
+ *
+ * Usage: ./bench/bench_users [n_users]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../users.h"
+#include "bench.h"
+
+static const char *bench_db = "/tmp/bench_users.db";
+
+static void generate_db(unsigned int n_users)
+{
+	FILE *db = fopen(bench_db, "w");
+
+	DIE(!db, "cannot create benchmark users.db");
+
+	fprintf(db, "%u\n", n_users);
+	for (unsigned int i = 0; i < n_users; i++)
+		fprintf(db, "user%u\n", i);
+
+	fclose(db);
+}
+
+/* The loader init_users() used before the arena was introduced */
+static char **legacy_load(unsigned int *n_users)
+{
+	FILE *db = fopen(bench_db, "r");
+	char temp[32];
+
+	DIE(!db, "cannot open benchmark users.db");
+	DIE(fscanf(db, "%u", n_users) != 1, "bad benchmark users.db");
+
+	char **names = malloc(*n_users * sizeof(char *));
+
+	DIE(!names, "malloc failed");
+	for (unsigned int i = 0; i < *n_users; i++) {
+		DIE(fscanf(db, "%31s", temp) != 1, "bad benchmark users.db");
+		names[i] = malloc(strlen(temp) + 1);
+		DIE(!names[i], "malloc failed");
+		strcpy(names[i], temp);
+	}
+
+	fclose(db);
+	return names;
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int n_users = argc > 1 ? atoi(argv[1]) : 1000000;
+	unsigned int legacy_n;
+	char name[32];
+
+	generate_db(n_users);
+
+	double start = bench_now();
+	char **legacy = legacy_load(&legacy_n);
+
+	bench_report("legacy fscanf + malloc load", n_users,
+				 bench_now() - start);
+
+	start = bench_now();
+	for (unsigned int i = 0; i < legacy_n; i++)
+		free(legacy[i]);
+	free(legacy);
+	bench_report("legacy free", n_users, bench_now() - start);
+
+	start = bench_now();
+	DIE(load_users_from(bench_db) < 0, "load_users_from failed");
+	bench_report("mmap + arena load", n_users, bench_now() - start);
+	DIE(get_users_number() != n_users, "wrong number of users loaded");
+
+	start = bench_now();
+	build_user_index();
+	bench_report("FNV index build", n_users, bench_now() - start);
+
+	start = bench_now();
+	for (unsigned int i = 0; i < n_users; i++) {
+		sprintf(name, "user%u", i);
+		get_user_id(name);
+	}
+	bench_report("get_user_id", n_users, bench_now() - start);
+
+	start = bench_now();
+	free_users();
+	bench_report("arena free", n_users, bench_now() - start);
+
+	remove(bench_db);
+	return 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * Benchmark of the tree walks on a deep repost chain, where every repost
+ * reposts the previous one (1M levels by default), and on a random cascade
+ * of the same size, which is shallow. The walks of generic_tree.c, posts.c
+ * and feed.c use g_tree_walk() and its explicit stack; the previous
+ * recursive count is kept here as the baseline. On the deep chain it is run
+ * in a child process, since it overflows the stack. The count is also done
+ * by scanning the preorder tags of the tree, as get-reposts does.
+ *
+ * Usage: ./bench/bench_walk [nodes] [recursive_chain]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../posts.h"
+#include "bench.h"
+
+static int next_id = 1;
+
+static int add_node(g_tree_t *tree, int parent_id)
+{
+	info *data = create_info(tree, next_id, 0, parent_id ? NULL : "post");
+
+	insert_node(tree, data, parent_id);
+	free(data);
+	return next_id++;
+}
+
+/* Every repost reposts the previous one */
+static g_tree_t *build_chain(g_tree_t *tree, int nodes, int *last_id)
+{
+	*last_id = add_node(tree, 0);
+	for (int i = 1; i < nodes; i++)
+		*last_id = add_node(tree, *last_id);
+	return tree;
+}
+
+/* Every repost reposts a random earlier one */
+static g_tree_t *build_cascade(int nodes, int *last_id)
+{
+	g_tree_t *tree = init_generic_tree_in_arena(sizeof(info), 0);
+	int first_id = add_node(tree, 0);
+
+	for (int i = 1; i < nodes; i++)
+		*last_id = add_node(tree, first_id + rand() % i);
+	return tree;
+}
+
+/* count_tree_nodes_recursive() before g_tree_walk() */
+static int legacy_count(g_node_t *node)
+{
+	int count = 1;
+
+	for (int i = 0; i < node->n_children; i++)
+		count += legacy_count(node->children[i]);
+
+	return count;
+}
+
+static int count_visit(g_node_t *node, int level, void *arg)
+{
+	(void)node;
+	(void)level;
+	(*(int *)arg)++;
+	return 0;
+}
+
+static void bench_recursive(const char *name, g_tree_t *tree)
+{
+	double start = bench_now();
+	int count = legacy_count(tree->root);
+
+	bench_report(name, count, bench_now() - start);
+}
+
+/* Runs the recursive count in a child, which may die of a stack overflow */
+static void bench_recursive_child(const char *name, g_tree_t *tree)
+{
+	fflush(stderr);
+	pid_t pid = fork();
+
+	DIE(pid < 0, "fork failed");
+	if (pid == 0) {
+		bench_recursive(name, tree);
+		_exit(0);
+	}
+
+	int status;
+
+	waitpid(pid, &status, 0);
+	if (WIFSIGNALED(status))
+		fprintf(stderr, "%-40s killed by signal %d\n", name,
+				WTERMSIG(status));
+}
+
+static void bench_walks(const char *name, g_tree_t *tree, int last_id)
+{
+	char label[64];
+	double start;
+	int nodes = tree->size;
+
+	/* The first walk also pays for bringing the nodes into the cache */
+	snprintf(label, sizeof(label), "%s, recursive count", name);
+	bench_recursive_child(label, tree);
+	count_tree_nodes(tree);
+
+	snprintf(label, sizeof(label), "%s, count", name);
+	start = bench_now();
+	DIE(count_tree_nodes(tree) != nodes, "wrong count");
+	bench_report(label, nodes, bench_now() - start);
+
+	snprintf(label, sizeof(label), "%s, preorder tag scan", name);
+	int count = 0;
+
+	start = bench_now();
+	g_subtree_scan(tree->root, count_visit, &count);
+	bench_report(label, nodes, bench_now() - start);
+	DIE(count != nodes, "wrong scan");
+
+	snprintf(label, sizeof(label), "%s, search last", name);
+	start = bench_now();
+	DIE(!search_node_recursive(tree->root, last_id), "not found");
+	bench_report(label, nodes, bench_now() - start);
+
+	snprintf(label, sizeof(label), "%s, max likes", name);
+	int max_likes = 0, max_likes_id = 1;
+
+	start = bench_now();
+	find_max_likes_recursively(tree->root, &max_likes, &max_likes_id);
+	bench_report(label, nodes, bench_now() - start);
+
+	snprintf(label, sizeof(label), "%s, euler representation", name);
+	int *euler_vector = malloc(2 * nodes * sizeof(int));
+	int *level_vector = malloc(2 * nodes * sizeof(int));
+	int index = 0;
+
+	DIE(!euler_vector || !level_vector, "malloc failed");
+	start = bench_now();
+	create_euler_representation(tree->root, euler_vector, level_vector,
+								&index, 0);
+	bench_report(label, nodes, bench_now() - start);
+	DIE(index != 2 * nodes - 1, "wrong tour");
+	free(euler_vector);
+	free(level_vector);
+}
+
+int main(int argc, char **argv)
+{
+	int nodes = argc > 1 ? atoi(argv[1]) : 1000000;
+	int recursive_chain = argc > 2 ? atoi(argv[2]) : 50000;
+	int last_id;
+	double start;
+
+	srand(19);
+
+	g_tree_t *tree = build_chain(init_generic_tree_in_arena(sizeof(info), 0),
+								 nodes, &last_id);
+	bench_walks("deep chain", tree, last_id);
+	free_g_tree(tree);
+
+	tree = build_cascade(nodes, &last_id);
+	bench_walks("random cascade", tree, last_id);
+	free_g_tree(tree);
+
+	/* A chain short enough for the recursion */
+	tree = build_chain(init_generic_tree_in_arena(sizeof(info), 0),
+					   recursive_chain, &last_id);
+	start = bench_now();
+	DIE(count_tree_nodes(tree) != recursive_chain, "wrong count");
+	bench_report("short chain, count", recursive_chain, bench_now() - start);
+	bench_recursive("short chain, recursive count", tree);
+	free_g_tree(tree);
+
+	/* Every node of a tree without an arena is freed by the walk */
+	tree = build_chain(init_generic_tree(sizeof(info), free_value_post, 0),
+					   nodes, &last_id);
+	start = bench_now();
+	free_g_tree(tree);
+	bench_report("deep chain, delete without arena", nodes,
+				 bench_now() - start);
+
+	free_g_index();
+
+	return 0;
+}
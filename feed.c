@@ -3,111 +3,577 @@
 #include <string.h>
 
 #include "feed.h"
+#include "timeline.h"
 #include "users.h"
+#include "workspace.h"
 
-void feed(list_graph_t *graph, tree_post_manager *post_manager,
-		  char *name, int feed_size)
+/* Newest post of an author that is not in the feed yet */
+typedef struct {
+	const int *posts; /* Posts of the author, in ascending ID order. */
+	int next; /* Position of the newest post left, -1 if there is none. */
+	int user_id; /* The author. */
+} feed_cursor_t;
+
+/* Moves a cursor down the max-heap of cursors, ordered by their next post */
+static void feed_sift_down(feed_cursor_t *heap, int size, int i)
 {
-	int user_id = get_user_id(name);
-	linked_list_t *friends_list = lg_get_neighbours(graph, user_id);
+	feed_cursor_t cursor = heap[i];
 
-	int *frequency = calloc(MAX_PEOPLE, sizeof(int));
-	DIE(!frequency, "calloc failed\n");
+	while (2 * i + 1 < size) {
+		int child = 2 * i + 1;
 
-	ll_node_t *current_friend = friends_list->head;
-	while (current_friend) {
-		frequency[*(int *)current_friend->data] = 1;
-		current_friend = current_friend->next;
+		if (child + 1 < size && heap[child + 1].posts[heap[child + 1].next] >
+			heap[child].posts[heap[child].next])
+			child++;
+		if (heap[child].posts[heap[child].next] <= cursor.posts[cursor.next])
+			break;
+		heap[i] = heap[child];
+		i = child;
 	}
-	frequency[user_id] = 1;
+	heap[i] = cursor;
+}
 
-	for (int i = post_manager->n_posts - 1; i >= 0; i--) {
-		if (feed_size == 0)
-			break;
-		g_node_t *root = post_manager->posts[i]->root;
-		int root_user_id = ((info *)root->data)->user_id;
-		if (frequency[root_user_id] == 1) {
-			printf("%s: %s\n", get_user_name(root_user_id),
-				   ((info *)root->data)->title);
-			feed_size--;
+/* Authors whose lists of posts are merged */
+#define MERGE_ALL 0
+#define MERGE_PUSHED 1
+#define MERGE_CELEBRITIES 2
+
+/* Last feed printed for a user */
+typedef struct {
+	unsigned long version; /* Bumped by every change that may alter it. */
+	unsigned long cached_version; /* Version when the feed was cached. */
+	int feed_size; /* Number of posts asked for, 0 if none is cached. */
+	int_vector_t posts; /* The posts that were printed, newest first. */
+} feed_cache_t;
+
+static int feed_mode = FEED_DEFAULT_MODE;
+static int celebrity_degree = FEED_CELEBRITY_DEGREE;
+static feed_stats stats;
+
+/* Cached feed of every user, indexed by user id */
+static int use_cache = 1;
+static feed_cache_t *caches;
+static int n_caches;
+
+/* Counts a request, the counters of the last request start from 0 */
+static void start_request(void)
+{
+	stats.requests++;
+	stats.last_merged = 0;
+	stats.last_fanout = 0;
+}
+
+static void count_merged(unsigned long merged)
+{
+	stats.merged += merged;
+	stats.last_merged += merged;
+}
+
+static void count_fanout(unsigned long fanout)
+{
+	stats.fanout += fanout;
+	stats.last_fanout += fanout;
+}
+
+/* The posts of a celebrity are not pushed, in hybrid mode */
+static int is_celebrity(list_graph_t *graph, int user_id)
+{
+	int degree;
+
+	if (feed_mode != FEED_HYBRID)
+		return 0;
+	lg_neighbours(graph, user_id, &degree);
+	return degree > celebrity_degree;
+}
+
+/*
+ * Takes a cursor on the newest post of the user and of every friend (only
+ * the ones selected by authors) that has posts, in a heap with room for
+ * extra more cursors. Sets size to the number of cursors.
+ */
+static feed_cursor_t *start_merge(list_graph_t *graph,
+								  tree_post_manager *post_manager,
+								  query_workspace_t *ws, int user_id,
+								  int authors, int extra, int *size)
+{
+	int n_friends, celebrities = authors == MERGE_CELEBRITIES;
+	const int *friends = lg_neighbours(graph, user_id, &n_friends);
+	feed_cursor_t *heap = ws_scratch(ws, (n_friends + 1 + extra) *
+									 sizeof(*heap));
+
+	*size = 0;
+	for (int i = -1; i < n_friends; i++) {
+		int author = i < 0 ? user_id : friends[i];
+		int n_posts;
+		const int *own;
+
+		if (i >= 0 && author == user_id)
+			continue;
+		if (authors != MERGE_ALL &&
+			is_celebrity(graph, author) != celebrities)
+			continue;
+
+		own = get_author_posts(post_manager, author, &n_posts);
+		if (n_posts > 0)
+			heap[(*size)++] = (feed_cursor_t){own, n_posts - 1, author};
+	}
+	return heap;
+}
+
+/*
+ * Merges the cursors of the heap into posts, newest first, up to limit IDs.
+ * Returns the number of IDs and sets next to the newest post that was left
+ * out, 0 if there is none.
+ */
+static int run_merge(feed_cursor_t *heap, int size, int limit, int *posts,
+					 int *next)
+{
+	int n_merged = 0;
+
+	count_merged(size);
+	for (int i = size / 2 - 1; i >= 0; i--)
+		feed_sift_down(heap, size, i);
+
+	/* The post IDs grow with time, so the newest post is the largest ID */
+	while (n_merged < limit && size > 0) {
+		posts[n_merged++] = heap[0].posts[heap[0].next];
+
+		if (--heap[0].next < 0)
+			heap[0] = heap[--size];
+		if (size > 0)
+			feed_sift_down(heap, size, 0);
+	}
+
+	*next = size > 0 ? heap[0].posts[heap[0].next] : 0;
+	return n_merged;
+}
+
+static void print_feed_post(tree_post_manager *post_manager, int post_id)
+{
+	info *data = search_g_tree(post_manager, post_id)->root->data;
+
+	printf("%s: %s\n", get_user_name(data->user_id), data->title);
+}
+
+void feed_set_mode(int mode)
+{
+	/* The timelines are rebuilt when they are read again */
+	if (mode != feed_mode)
+		tl_free();
+	feed_mode = mode;
+}
+
+int feed_get_mode(void)
+{
+	return feed_mode;
+}
+
+void feed_set_celebrity_degree(int degree)
+{
+	if (degree != celebrity_degree)
+		tl_free();
+	celebrity_degree = degree;
+}
+
+void feed_set_cache(int enabled)
+{
+	if (!enabled)
+		free_feed_cache();
+	use_cache = enabled;
+}
+
+/* Invalidates the cached feed of a user */
+static void bump_version(int user_id)
+{
+	if (user_id >= 0 && user_id < n_caches)
+		caches[user_id].version++;
+}
+
+/*
+ * Prints the cached feed of a user, if it is up to date and holds the
+ * first feed_size posts. Returns 0 if it cannot be used.
+ */
+static int read_cache(tree_post_manager *post_manager, int user_id,
+					  int feed_size)
+{
+	if (!use_cache || user_id < 0)
+		return 0;
+
+	feed_cache_t *cache = user_id < n_caches ? &caches[user_id] : NULL;
+
+	/* A feed shorter than asked for holds every post of the authors */
+	if (!cache || !cache->feed_size ||
+		cache->cached_version != cache->version ||
+		(feed_size > cache->feed_size &&
+		 cache->posts.size == (unsigned int)cache->feed_size)) {
+		stats.cache_misses++;
+		return 0;
+	}
+
+	unsigned int n_posts = cache->posts.size < (unsigned int)feed_size ?
+						   cache->posts.size : (unsigned int)feed_size;
+
+	/*
+	 * The deletions do not bump the versions: a deleted post only changes
+	 * the feeds that show it, which are found here.
+	 */
+	for (unsigned int i = 0; i < n_posts; i++) {
+		if (!search_g_tree(post_manager, cache->posts.data[i])) {
+			cache->feed_size = 0;
+			stats.cache_misses++;
+			return 0;
 		}
 	}
-	free(frequency);
+
+	for (unsigned int i = 0; i < n_posts; i++)
+		print_feed_post(post_manager, cache->posts.data[i]);
+	stats.cache_hits++;
+	return 1;
 }
 
-void print_reposts_recursive(g_node_t *node, int level, int user_id,
-							 char *title)
+static void write_cache(int user_id, int feed_size, const int *posts,
+						int n_posts)
 {
-	if (!node)
+	if (!use_cache || user_id < 0)
 		return;
 
-	if (level != 0) {
-		if (((info *)node->data)->user_id == user_id)
-			printf("Reposted: %s\n", title);
+	if (user_id >= n_caches) {
+		int n_users = n_caches ? n_caches : 64;
+
+		while (n_users <= user_id)
+			n_users *= 2;
+
+		feed_cache_t *grown = realloc(caches, n_users * sizeof(*grown));
+
+		DIE(!grown, "realloc feed caches failed");
+		memset(grown + n_caches, 0, (n_users - n_caches) * sizeof(*grown));
+		caches = grown;
+		n_caches = n_users;
 	}
 
-	for (int i = 0; i < node->n_children; i++)
-		print_reposts_recursive(node->children[i], level + 1, user_id, title);
+	feed_cache_t *cache = &caches[user_id];
+
+	iv_reserve(&cache->posts, n_posts);
+	if (n_posts > 0)
+		memcpy(cache->posts.data, posts, n_posts * sizeof(*posts));
+	cache->posts.size = n_posts;
+	cache->feed_size = feed_size;
+	cache->cached_version = cache->version;
 }
 
-void view_profile(tree_post_manager *post_manager, char *name)
+void free_feed_cache(void)
+{
+	for (int i = 0; i < n_caches; i++)
+		iv_free(&caches[i].posts);
+	free(caches);
+	caches = NULL;
+	n_caches = 0;
+}
+
+/*
+ * Builds the timeline of a user from the lists of posts of the authors,
+ * with the workspace of the feed query.
+ */
+static timeline_t *build_timeline(list_graph_t *graph,
+								  tree_post_manager *post_manager,
+								  query_workspace_t *ws, int user_id)
+{
+	int *posts = ws_buffer(ws, 1, TL_CAPACITY);
+	int size, next;
+	feed_cursor_t *heap = start_merge(graph, post_manager, ws, user_id,
+									  MERGE_PUSHED, 0, &size);
+	int n_posts = run_merge(heap, size, TL_CAPACITY, posts, &next);
+	timeline_t *tl = tl_create(user_id);
+
+	for (int i = n_posts - 1; i >= 0; i--) {
+		info *data = search_g_tree(post_manager, posts[i])->root->data;
+
+		tl_push(tl, posts[i], data->user_id);
+	}
+	tl->horizon = next;
+	count_fanout(n_posts);
+
+	return tl;
+}
+
+static int is_deleted(const tl_entry_t *entry, void *arg)
+{
+	return !search_g_tree(arg, entry->post_id);
+}
+
+static int is_by_author(const tl_entry_t *entry, void *arg)
+{
+	return entry->user_id == *(int *)arg;
+}
+
+/*
+ * Reads the feed from the timeline into posts, merged with the posts of the
+ * celebrities in hybrid mode, with the workspace of the feed query (posts
+ * is its buffer 0). Returns the number of posts, or -1 if the timeline has
+ * too few posts.
+ */
+static int push_feed(list_graph_t *graph, tree_post_manager *post_manager,
+					 query_workspace_t *ws, int user_id, int feed_size,
+					 int *posts)
+{
+	timeline_t *tl = tl_get(user_id);
+
+	if (!tl)
+		tl = build_timeline(graph, post_manager, ws, user_id);
+
+	unsigned int n_live = 0, i;
+
+	for (i = 0; i < tl->size && n_live < (unsigned int)feed_size; i++) {
+		if (search_g_tree(post_manager, tl_newest(tl, i)->post_id))
+			n_live++;
+	}
+
+	/* The deleted posts are dropped when a feed reaches them */
+	if (n_live < i)
+		tl_remove_if(tl, is_deleted, post_manager);
+
+	/* The posts older than the horizon are not in the timeline */
+	if (n_live < (unsigned int)feed_size && tl->horizon)
+		return -1;
+
+	if (feed_mode != FEED_HYBRID) {
+		for (i = 0; i < n_live; i++)
+			posts[i] = tl_newest(tl, i)->post_id;
+		return n_live;
+	}
+
+	/* The timeline is one more sorted list for the merge */
+	int *pushed = ws_buffer(ws, 1, n_live);
+	int size, next;
+	feed_cursor_t *heap = start_merge(graph, post_manager, ws, user_id,
+									  MERGE_CELEBRITIES, 1, &size);
+
+	for (i = 0; i < n_live; i++)
+		pushed[n_live - 1 - i] = tl_newest(tl, i)->post_id;
+	if (n_live > 0)
+		heap[size++] = (feed_cursor_t){pushed, n_live - 1, -1};
+
+	return run_merge(heap, size, feed_size, posts, &next);
+}
+
+void feed(list_graph_t *graph, tree_post_manager *post_manager,
+		  char *name, int feed_size)
 {
 	int user_id = get_user_id(name);
 
-	for (int i = 0; i < post_manager->n_posts; i++) {
-		g_node_t *root = post_manager->posts[i]->root;
-		int root_user_id = ((info *)root->data)->user_id;
-		if (root_user_id == user_id)
-			printf("Posted: %s\n",  ((info *)root->data)->title);
+	start_request();
+	if (feed_size <= 0 || read_cache(post_manager, user_id, feed_size))
+		return;
+
+	/* The feed cannot hold more posts than there are live ones */
+	int limit = post_manager->n_posts - post_manager->n_deleted;
+
+	if (limit > feed_size)
+		limit = feed_size;
+
+	query_workspace_t *ws = ws_acquire(graph->nodes);
+	int *posts = ws_buffer(ws, 0, limit);
+	int n_posts = -1;
+
+	if (feed_mode != FEED_PULL && user_id >= 0)
+		n_posts = push_feed(graph, post_manager, ws, user_id, limit, posts);
+
+	if (n_posts < 0) {
+		int size, next;
+		feed_cursor_t *heap = start_merge(graph, post_manager, ws, user_id,
+										  MERGE_ALL, 0, &size);
+
+		if (feed_mode != FEED_PULL)
+			stats.fallbacks++;
+		n_posts = run_merge(heap, size, limit, posts, &next);
+	}
+
+	for (int i = 0; i < n_posts; i++)
+		print_feed_post(post_manager, posts[i]);
+	write_cache(user_id, feed_size, posts, n_posts);
+}
+
+void feed_post_created(list_graph_t *graph, tree_post_manager *post_manager,
+					   int post_id)
+{
+	g_tree_t *post_tree = search_g_tree(post_manager, post_id);
+
+	start_request();
+	if (!post_tree)
+		return;
+
+	int author = ((info *)post_tree->root->data)->user_id;
+
+	if (author < 0)
+		return;
+
+	int n_friends;
+	const int *friends = lg_neighbours(graph, author, &n_friends);
+
+	/* The post goes first in the feeds of the author and of the friends */
+	for (int i = -1; use_cache && i < n_friends; i++)
+		bump_version(i < 0 ? author : friends[i]);
+
+	/* The posts of a celebrity are merged when the feeds are read */
+	if (feed_mode == FEED_PULL || is_celebrity(graph, author))
+		return;
+
+	/* Only the timelines that were built are kept up to date */
+	timeline_t *tl = tl_get(author);
+
+	if (tl) {
+		tl_push(tl, post_id, author);
+		count_fanout(1);
 	}
-	for (int i = 0; i < post_manager->n_posts; i++) {
-		g_node_t *root = post_manager->posts[i]->root;
-		print_reposts_recursive(root, 0, user_id, ((info *)root->data)->title);
+	for (int i = 0; i < n_friends; i++) {
+		tl = tl_get(friends[i]);
+		if (tl && friends[i] != author) {
+			tl_push(tl, post_id, author);
+			count_fanout(1);
+		}
+	}
+}
+
+/*
+ * Drops the timelines that hold (or should hold) the posts of a user whose
+ * degree just crossed the celebrity degree; they are rebuilt on their next
+ * read. A degree only crosses it by one friendship at a time, so this is
+ * rare.
+ */
+static void update_celebrity(list_graph_t *graph, int user_id, int friend)
+{
+	int n_friends;
+	const int *friends = lg_neighbours(graph, user_id, &n_friends);
+	int added = lg_has_edge(graph, user_id, friend);
+
+	if (n_friends != celebrity_degree + added)
+		return;
+
+	tl_drop(user_id);
+	for (int i = 0; i < n_friends; i++)
+		tl_drop(friends[i]);
+}
+
+/* Adds or removes the posts of author in the timeline of user_id */
+static void sync_timeline(list_graph_t *graph,
+						  tree_post_manager *post_manager,
+						  int user_id, int author)
+{
+	timeline_t *tl = tl_get(user_id);
+
+	if (!tl)
+		return;
+
+	if (lg_has_edge(graph, user_id, author)) {
+		int n_posts;
+		const int *posts = get_author_posts(post_manager, author, &n_posts);
+
+		if (!is_celebrity(graph, author))
+			count_fanout(tl_merge(tl, posts, n_posts, author));
+	} else {
+		tl_remove_if(tl, is_by_author, &author);
 	}
 }
 
-void check_friends_who_reposted(g_node_t *node, int level,
-								int **frequency)
+void feed_friendship_changed(list_graph_t *graph,
+							 tree_post_manager *post_manager,
+							 int user_1, int user_2)
 {
-	if (!node)
+	start_request();
+	if (user_1 < 0 || user_2 < 0)
+		return;
+
+	if (user_1 != user_2) {
+		bump_version(user_1);
+		bump_version(user_2);
+	}
+	if (feed_mode == FEED_PULL)
 		return;
 
-	if (level != 0) {
-		if ((*frequency)[((info *)node->data)->user_id] == 1)
-			(*frequency)[((info *)node->data)->user_id] = 2;
+	/* A friendship with oneself changes the degree but not the feed */
+	if (feed_mode == FEED_HYBRID)
+		update_celebrity(graph, user_1, user_2);
+	if (user_1 == user_2)
+		return;
+	if (feed_mode == FEED_HYBRID)
+		update_celebrity(graph, user_2, user_1);
+	sync_timeline(graph, post_manager, user_1, user_2);
+	sync_timeline(graph, post_manager, user_2, user_1);
+}
+
+void get_feed_stats(feed_stats *feed_stats)
+{
+	if (feed_stats)
+		*feed_stats = stats;
+}
+
+void reset_feed_stats(void)
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void view_profile(tree_post_manager *post_manager, char *name)
+{
+	int user_id = get_user_id(name);
+	int n_posts;
+	const int *posts = get_author_posts(post_manager, user_id, &n_posts);
+
+	for (int i = 0; i < n_posts; i++) {
+		g_tree_t *post_tree = search_g_tree(post_manager, posts[i]);
+
+		printf("Posted: %s\n", ((info *)post_tree->root->data)->title);
 	}
 
-	for (int i = 0; i < node->n_children; i++)
-		check_friends_who_reposted(node->children[i], level + 1, frequency);
+	int n_reposts;
+	const repost_entry_t *reposts = get_user_reposts(post_manager, user_id,
+													 &n_reposts);
+
+	for (int i = 0; i < n_reposts; i++) {
+		g_tree_t *post_tree = search_g_tree(post_manager, reposts[i].post_id);
+
+		printf("Reposted: %s\n", ((info *)post_tree->root->data)->title);
+	}
 }
 
 void friends_repost(list_graph_t *graph, tree_post_manager *post_manager,
 					char *name, int post_id)
 {
-	g_tree_t *post_tree = search_g_tree(post_manager, post_id);
+	const like_set_t *reposters = get_reposters(post_manager, post_id);
 
-	if (!post_tree)
+	if (!reposters)
 		return;
 
 	int user_id = get_user_id(name);
-	linked_list_t *friends_list = lg_get_neighbours(graph, user_id);
+	const unsigned long *friend_bits, *repost_bits;
+	unsigned int n_friend_words, n_repost_words;
+
+	/* The bits of the words are visited in id order */
+	if (lg_neighbour_bits(graph, user_id, &friend_bits, &n_friend_words) &&
+		ls_bitmap(reposters, &repost_bits, &n_repost_words)) {
+		unsigned int n_words = n_friend_words < n_repost_words ?
+							   n_friend_words : n_repost_words;
 
-	int *frequency = calloc(MAX_PEOPLE, sizeof(int));
-	DIE(!frequency, "calloc failed\n");
+		for (unsigned int i = 0; i < n_words; i++) {
+			unsigned long both = friend_bits[i] & repost_bits[i];
 
-	ll_node_t *current_friend = friends_list->head;
-	while (current_friend) {
-		frequency[*(int *)current_friend->data] = 1;
-		current_friend = current_friend->next;
+			while (both) {
+				int bit = __builtin_ctzl(both);
+
+				printf("%s\n", get_user_name(i * 8 * sizeof(both) + bit));
+				both &= both - 1;
+			}
+		}
+		return;
 	}
 
-	check_friends_who_reposted(post_tree->root, 0, &frequency);
+	int n_friends;
+	const int *friends = lg_neighbours(graph, user_id, &n_friends);
 
-	for (int i = 0; i < MAX_PEOPLE; i++) {
-		if (frequency[i] == 2)
-			printf("%s\n", get_user_name(i));
+	/* The friends are sorted, so they are printed in id order */
+	for (int i = 0; i < n_friends; i++) {
+		if (ls_contains(reposters, friends[i]))
+			printf("%s\n", get_user_name(friends[i]));
 	}
-	free(frequency);
 }
 
 void sort_friends_by_connections(friends_info *friends_vector, int n_friends)
@@ -150,33 +616,30 @@ void sort_friends_by_id(friends_info *friends_vector, int n_friends)
 void common_groups(list_graph_t *graph, char *name)
 {
 	int user_id = get_user_id(name);
-	linked_list_t *friends_list = lg_get_neighbours(graph, user_id);
+	int n_user_friends;
+	const int *user_friends = lg_neighbours(graph, user_id, &n_user_friends);
 
-	int *frequency = calloc(MAX_PEOPLE, sizeof(int));
-	DIE(!frequency, "calloc failed\n");
+	query_workspace_t *ws = ws_acquire(graph->nodes);
 	// asta e un vector cu toti prietenii lui user_id
 	friends_info *friends_vector =
-	calloc(ll_get_size(friends_list), sizeof(friends_info));
-	DIE(!friends_vector, "calloc failed\n");
+	ws_scratch(ws, (n_user_friends + 1) * sizeof(friends_info));
 
 	int n_friends = 0;
-	ll_node_t *current_friend = friends_list->head;
 
-	while (current_friend) {
-		friends_vector[n_friends].id = *(int *)current_friend->data;
+	for (int i = 0; i < n_user_friends; i++) {
+		friends_vector[n_friends].id = user_friends[i];
+		friends_vector[n_friends].n_connections = 0;
 		n_friends++;
-		frequency[*(int *)current_friend->data] = 1;
-		current_friend = current_friend->next;
+		ws_set(ws, user_friends[i], 1);
 	}
 
 	for (int i = 0; i < n_friends; i++) {
-		linked_list_t *friends__of_friends_list =
-		lg_get_neighbours(graph, friends_vector[i].id);
-		ll_node_t *current_friend_of_friend = friends__of_friends_list->head;
-		while (current_friend_of_friend) {
-			if (frequency[*(int *)current_friend_of_friend->data] == 1)
+		int n_friends_of_friend;
+		const int *friends_of_friend =
+		lg_neighbours(graph, friends_vector[i].id, &n_friends_of_friend);
+		for (int j = 0; j < n_friends_of_friend; j++) {
+			if (ws_get(ws, friends_of_friend[j]) == 1)
 				friends_vector[i].n_connections++;
-			current_friend_of_friend = current_friend_of_friend->next;
 		}
 	}
 
@@ -189,16 +652,14 @@ void common_groups(list_graph_t *graph, char *name)
 			n_remaining_friends = i + 1;
 			break;
 		}
-		linked_list_t *friends__of_friends_list =
-		lg_get_neighbours(graph, friends_vector[i].id);
-		ll_node_t *current_friend_of_friend = friends__of_friends_list->head;
-		while (current_friend_of_friend) {
+		int n_friends_of_friend;
+		const int *friends_of_friend =
+		lg_neighbours(graph, friends_vector[i].id, &n_friends_of_friend);
+		for (int k = 0; k < n_friends_of_friend; k++) {
 			for (int j = 0; j < i; j++) {
-				if (friends_vector[j].id ==
-					*(int *)current_friend_of_friend->data)
+				if (friends_vector[j].id == friends_of_friend[k])
 					friends_vector[j].n_connections--;
 			}
-			current_friend_of_friend = current_friend_of_friend->next;
 		}
 		n_remaining_friends--;
 		sort_friends_by_connections(friends_vector, n_remaining_friends);
@@ -213,8 +674,6 @@ void common_groups(list_graph_t *graph, char *name)
 	printf("The closest friend group of %s is:\n", name);
 	for (int i = 0; i < n_remaining_friends; i++)
 		printf("%s\n", get_user_name(friends_vector[i].id));
-	free(frequency);
-	free(friends_vector);
 }
 
 void handle_input_feed(char *input, list_graph_t *graph,
@@ -231,6 +690,14 @@ void handle_input_feed(char *input, list_graph_t *graph,
 		char *token = strtok(NULL, "\n ");
 		int feed_size = atoi(token);
 		feed(graph, post_manager, name, feed_size);
+	} else if (!strcmp(cmd, "create")) {
+		/* The post handler already created it, with the last ID */
+		feed_post_created(graph, post_manager, post_manager->id_counter - 1);
+	} else if (!strcmp(cmd, "add") || !strcmp(cmd, "remove")) {
+		char *name_1 = strtok(NULL, "\n ");
+		char *name_2 = strtok(NULL, "\n ");
+		feed_friendship_changed(graph, post_manager, get_user_id(name_1),
+								get_user_id(name_2));
 	} else if (!strcmp(cmd, "view-profile")) {
 		char *name = strtok(NULL, "\n ");
 		view_profile(post_manager, name);
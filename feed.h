@@ -3,27 +3,157 @@
 
 #include "friends.h"
 #include "posts.h"
+#include "workspace.h"
+
+/* The feed merges the lists of posts of the user and their friends */
+#define FEED_PULL 0
+/* The feed is read from the timeline of the user (see timeline.h) */
+#define FEED_PUSH 1
+/*
+ * The posts of the celebrities (users with more than the celebrity degree
+ * of friends) are not pushed; the feed merges the timeline of the user
+ * with the lists of posts of the celebrities among them and their friends.
+ */
+#define FEED_HYBRID 2
+/* Mode of the feed command when the program starts */
+#define FEED_DEFAULT_MODE FEED_HYBRID
+/* Users with more friends than this are celebrities in hybrid mode */
+#define FEED_CELEBRITY_DEGREE 1000
 
 typedef struct {
 	int n_connections;
 	int id;
 } friends_info;
 
+/**
+ * @brief Counters of the feed engine. A request is a feed, a new post or a
+ * friendship change.
+ */
+typedef struct {
+	unsigned long requests; /* Number of requests. */
+	unsigned long merged; /* Lists of posts merged when reading feeds. */
+	unsigned long fanout; /* Posts written into timelines. */
+	unsigned long fallbacks; /* Feeds that a timeline could not serve. */
+	unsigned long cache_hits; /* Feeds printed from the cache. */
+	unsigned long cache_misses; /* Feeds the cache could not serve. */
+	unsigned long last_merged; /* Lists merged by the last request. */
+	unsigned long last_fanout; /* Posts written by the last request. */
+} feed_stats;
+
+/**
+ * @brief Selects how the feed command is answered: FEED_PULL, FEED_PUSH or
+ * FEED_HYBRID. Switching modes drops the timelines; they are built again
+ * by the first feed of every user.
+ *
+ * @param mode The new mode.
+ */
+void feed_set_mode(int mode);
+
+/**
+ * @brief Gets the mode of the feed command.
+ *
+ * @return FEED_PULL, FEED_PUSH or FEED_HYBRID.
+ */
+int feed_get_mode(void);
+
+/**
+ * @brief Sets the number of friends above which the posts of a user are not
+ * pushed in hybrid mode (FEED_CELEBRITY_DEGREE by default). Changing it
+ * drops the timelines.
+ *
+ * @param degree The new celebrity degree.
+ */
+void feed_set_celebrity_degree(int degree);
+
+/**
+ * @brief Turns the cache of the last feed of every user on or off (it is on
+ * when the program starts). Turning it off frees the cached feeds.
+ *
+ * @param enabled 1 to cache the feeds, 0 otherwise.
+ */
+void feed_set_cache(int enabled);
+
+/**
+ * @brief Frees the cached feeds.
+ */
+void free_feed_cache(void);
+
+/**
+ * @brief Gets the counters of the feed engine.
+ *
+ * @param stats Where to store the counters.
+ */
+void get_feed_stats(feed_stats *stats);
+
+/**
+ * @brief Resets the counters of the feed engine.
+ */
+void reset_feed_stats(void);
+
+/**
+ * @brief Pushes a new post into the timelines of its author and of the
+ * friends of the author, in push mode, or in hybrid mode if the author is
+ * not a celebrity. Only the timelines that were already built are updated,
+ * the others are built from the lists of posts when they are first read.
+ * In every mode, the cached feeds of the author and of their friends are
+ * invalidated.
+ *
+ * @param graph The social graph.
+ * @param post_manager The post manager containing the post.
+ * @param post_id The ID of the new post.
+ */
+void feed_post_created(list_graph_t *graph, tree_post_manager *post_manager,
+					   int post_id);
+
+/**
+ * @brief Updates the timelines of two users after their friendship was
+ * added or removed, in push and hybrid mode: if they are friends now, the
+ * posts of each one are merged into the timeline of the other (backfill),
+ * otherwise they are removed from it (eviction). In hybrid mode, if the
+ * degree of one of them crossed the celebrity degree, the timelines of that
+ * user and of their friends are dropped, to be rebuilt on their next read.
+ * In every mode, the cached feeds of the two users are invalidated.
+ *
+ * @param graph The social graph, already updated.
+ * @param post_manager The post manager.
+ * @param user_1 The first user.
+ * @param user_2 The second user.
+ */
+void feed_friendship_changed(list_graph_t *graph,
+							 tree_post_manager *post_manager,
+							 int user_1, int user_2);
+
 /**
  * @brief Displays the feed for a user, showing recent posts from friends.
  * Get the user ID corresponding to the given user name.
- * Retrieve the user's friends list from the graph data structure.
- * Create an array to keep track of which users' posts have already been
- * included in the feed. Initialize it to mark the user and their friends.
- * Generate Feed:
- *		Iterate through the posts in the post manager's array in reverse order
- *		(from newest to oldest).
- *		Check if the feed size limit has been reached or if there are no more
- *		posts to process.
- *		For each post, check if the post's author is a friend of the user.
- *		If so, print the post title along with the author's name.
- *		Decrement the feed size counter after printing each eligible post.
- * Free the memory allocated for the frequency array.
+ * If the cache holds the last feed of the user, no post or friendship that
+ * could change it was made since (its version did not move), it has the
+ * first feed_size posts and none of them was deleted, print it again.
+ * Otherwise build the feed in the current mode, print it and cache it.
+ * Push mode:
+ *		Get the timeline of the user, or build it with the pull merge below
+ *		if the user has none yet. Drop the deleted posts from it.
+ *		If it holds at least feed_size posts, or every post of the feed
+ *		(nothing was dropped past its horizon), print the newest feed_size
+ *		posts along with their authors' names, in O(feed_size).
+ *		Otherwise fall back to the pull mode.
+ * Hybrid mode:
+ *		Same as the push mode, but the timeline only holds the posts of the
+ *		users that are not celebrities, so its newest feed_size posts are
+ *		merged with the lists of posts of the celebrities among the user and
+ *		their friends, like in the pull mode.
+ * Pull mode:
+ *		Retrieve the user's friends list from the graph data structure.
+ *		Take a cursor on the newest post of the user and of every friend
+ *		from their lists of posts, and arrange the cursors in a max-heap (in
+ *		the scratch memory of the query workspace) ordered by post ID, which
+ *		is also the creation order.
+ *		Until the feed size limit is reached or there are no more posts,
+ *		take the post at the top of the heap, then move that cursor to the
+ *		previous post of the same author. Print the posts along with their
+ *		authors' names.
+ *		Only the posts of the user and their friends are read, so a feed of
+ *		k posts costs O(friends + k log friends).
  *
  * @param graph The social graph.
  * @param post_manager The post manager containing all posts.
@@ -33,72 +163,34 @@ typedef struct {
 void feed(list_graph_t *graph, tree_post_manager *post_manager,
 		  char *name, int feed_size);
 
-/**
- * @brief Recursively prints the reposts of a given post by a specific user.
- * Base Case: If the current node is NULL, the function returns.
- * If the current node represents a repost made by the specified user,
- * print information about the repost.
- * Recursively call the function for each child node to explore the entire
- * repost tree structure.
- *
- * @param node The current node in the repost tree.
- * @param level The current level in the repost tree.
- * @param user_id The ID of the user whose reposts are to be printed.
- * @param title The title of the original post.
- */
-void print_reposts_recursive(g_node_t *node, int level, int user_id,
-							 char *title);
-
 /**
  * @brief Displays the profile of a user, including their posts and reposts.
  * Get the unique identifier for the user based on their name.
- * Iterate through the posts in the post manager's array.
- * If the author of a post matches the user ID, print the title of
- * the post as "Posted"
- * Iterate through the posts in the post manager's array again.
- * For each post, recursively traverse the repost tree structure using
- * the print_reposts_recursive function to check if the user has reposted it.
- * If so, print information about the repost.
+ * Print the title of every post in the list of posts of the user, in
+ * creation order, as "Posted".
+ * Then print the title of the original post of every repost in the list of
+ * reposts of the user, which is sorted by post, as "Reposted". Both lists
+ * are maintained by the post commands, so the cost only depends on the
+ * number of posts and reposts of the user.
  *
  * @param post_manager The post manager containing all posts.
  * @param name The name of the user whose profile is to be viewed.
  */
 void view_profile(tree_post_manager *post_manager, char *name);
 
-/**
- * @brief Recursively checks which friends have reposted a given post.
- * Base Case: If the current node is NULL, the function returns.
- * Check Level:
- * If the current level is not the root level (level 0), indicating that
- * this is a repost node:
- *		- check if the user who made the repost is a friend of
- *		the original poster.
- *		- if the user is a friend, update the frequency array to mark that
- *		the friend has reposted the content.
- * Recursively call the function for each child node to explore the entire
- * repost tree structure.
- *
- * @param node The current node in the repost tree.
- * @param level The current level in the repost tree.
- * @param frequency Pointer to an array tracking which friends have reposted.
- */
-void check_friends_who_reposted(g_node_t *node, int level,
-								int **frequency);
-
 /**
  * @brief Displays which friends of a user have reposted a specific post.
- * Search for the specified post ID in the post manager's tree structure.
+ * Get the set of the users who reposted the specified post.
  * If the post does not exist, the function returns.
- * Obtain the list of friends for the specified user from
- * the graph data structure.
- * Create an array to keep track of which users' friends have reposted
- * the specified post. Initialize it to mark the user's friends.
- * Traverse the repost tree structure of the specified post recursively using
- * the check_friends_who_reposted function to identify friends who have
- * reposted the content. Update the frequency array accordingly.
- * Iterate through the frequency array, and for each user whose friend has
- * reposted the content (marked with a frequency of 2), print their name.
- * Free the memory allocated for the frequency array.
+ * If the graph keeps the bitset of the friends of the user (small
+ * populations, see lg_neighbour_bits()) and the set is a bitmap, AND them
+ * word by word and print the name of every set bit, lowest first, so in id
+ * order: 64 users per word operation.
+ * Otherwise obtain the list of friends for the specified user from
+ * the graph data structure, which is sorted by id.
+ * Print the name of every friend that is in the set, so in id order.
+ * Every check is O(1), so the cost only depends on the number of friends,
+ * not on the number of reposts of the post.
  *
  * @param graph The social graph.
  * @param post_manager The post manager containing all posts.
@@ -142,17 +234,17 @@ void sort_friends_by_id(friends_info *friends_vector, int n_friends);
  * Retrieve the list of friends for the user from the graph.
  *
  * Initialize Data Structures:
- * Create an array frequency to ensure consideration of only the friends of
- * the user.
- * Allocate memory for the 'friends_vector' array to store information
- * about each friend.
+ * Mark the friends of the user in the query workspace, to ensure
+ * consideration of only the friends of the user.
+ * Take the 'friends_vector' array, which stores information about each
+ * friend, from the scratch memory of the workspace.
  * Initialize variables to track the number of friends (n_friends) and the
  * remaining friends (n_remaining_friends).
  *
  * Populate Friends Vector:
  * Traverse through the user's friend list.
  * Populate the friends_vector array with friend IDs and mark them
- * in the frequency array.
+ * in the workspace.
  *
  * Calculate Connections:
  * For each friend in the friends_vector, obtain their friends and
@@ -174,7 +266,6 @@ void sort_friends_by_id(friends_info *friends_vector, int n_friends);
  * and resort the friends vector each time.)
  *
  * Print the names of the users in the closest friend group for the given user.
- * Free the allocated memory for the frequency array and the friends_vector.
  *
  * @param graph The social graph.
  * @param name The name of the user whose common groups are to be displayed.
@@ -183,6 +274,8 @@ void common_groups(list_graph_t *graph, char *name);
 
 /**
  * @brief Handles input commands related to the feed and user interactions.
+ * The create, add and remove commands were already applied by the handlers
+ * of the posts and of the friends, so they only update the timelines.
  *
  * @param input The input string containing the command and arguments.
  * @param graph The social graph.
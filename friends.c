@@ -4,6 +4,7 @@
 
 #include "friends.h"
 #include "users.h"
+#include "workspace.h"
 
 void add_friend(list_graph_t *graph, char *name_1, char *name_2)
 {
@@ -27,57 +28,79 @@ void remove_friend(list_graph_t *graph, char *name_1, char *name_2)
 	printf("Removed connection %s - %s\n", name_1, name_2);
 }
 
+static int compare_ids(const void *a, const void *b)
+{
+	int id_a = *(const int *)a;
+	int id_b = *(const int *)b;
+
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+/*
+ * Advances i and j over two sorted arrays until they point past the next
+ * value found in both. The side that is behind gallops towards the other.
+ */
+static int next_common(const int *a, unsigned int n_a, unsigned int *i,
+					   const int *b, unsigned int n_b, unsigned int *j)
+{
+	while (*i < n_a && *j < n_b) {
+		if (a[*i] < b[*j]) {
+			*i = iv_gallop(a, n_a, *i, b[*j]);
+		} else if (a[*i] > b[*j]) {
+			*j = iv_gallop(b, n_b, *j, a[*i]);
+		} else {
+			(*j)++;
+			return a[(*i)++];
+		}
+	}
+
+	return -1;
+}
+
 void suggestions(list_graph_t *graph, char *name)
 {
 	int id = get_user_id(name);
 
-	int *frequency = calloc(MAX_PEOPLE, sizeof(int));
-	DIE(!frequency, "calloc failed\n");
+	int n_friends;
+	const int *friends = lg_neighbours(graph, id, &n_friends);
 
-	linked_list_t *friends_list = lg_get_neighbours(graph, id);
+	/* -1 marks the user and their friends, 1 marks the suggestions */
+	query_workspace_t *ws = ws_acquire(graph->nodes);
 
-	ll_node_t *current_friend = friends_list->head;
+	if (n_friends)
+		ws_set(ws, id, -1);
+	for (int i = 0; i < n_friends; i++)
+		ws_set(ws, friends[i], -1);
 
-	while (current_friend) {
-		linked_list_t *friends_of_friends_list =
-		lg_get_neighbours(graph, *(int *)current_friend->data);
-		ll_node_t *current_friend_of_friend = friends_of_friends_list->head;
-		while (current_friend_of_friend) {
-			frequency[*(int *)current_friend_of_friend->data] = 1;
-			current_friend_of_friend = current_friend_of_friend->next;
+	for (int i = 0; i < n_friends; i++) {
+		int n_friends_of_friend;
+		const int *friends_of_friend =
+		lg_neighbours(graph, friends[i], &n_friends_of_friend);
+		for (int j = 0; j < n_friends_of_friend; j++) {
+			if (!ws_get(ws, friends_of_friend[j]))
+				ws_set(ws, friends_of_friend[j], 1);
 		}
-		current_friend = current_friend->next;
 	}
 
-	current_friend = friends_list->head;
+	/* Only the touched nodes can be suggestions, sort them by id */
+	int *candidates = ws_buffer(ws, 0, ws->touched.size + 1);
+	int n_candidates = 0;
 
-	while (current_friend) {
-		frequency[*(int *)current_friend->data] = 0;
-		current_friend = current_friend->next;
-	}
-	frequency[id] = 0;
-
-	int have_suggestions = 0;
-
-	for (int i = 0; i < MAX_PEOPLE; i++) {
-		if (frequency[i] == 1) {
-			have_suggestions = 1;
-			break;
-		}
+	for (unsigned int i = 0; i < ws->touched.size; i++) {
+		if (ws_get(ws, ws->touched.data[i]) == 1)
+			candidates[n_candidates++] = ws->touched.data[i];
 	}
 
-	if (have_suggestions == 0) {
+	if (n_candidates == 0) {
 		printf("There are no suggestions for %s\n", name);
-		free(frequency);
 		return;
 	}
-	printf("Suggestions for %s:\n", name);
 
-	for (int i = 0; i < MAX_PEOPLE; i++) {
-		if (frequency[i] == 1)
-			printf("%s\n", get_user_name(i));
-	}
-	free(frequency);
+	qsort(candidates, n_candidates, sizeof(int), compare_ids);
+
+	printf("Suggestions for %s:\n", name);
+	for (int i = 0; i < n_candidates; i++)
+		printf("%s\n", get_user_name(candidates[i]));
 }
 
 void get_distance(list_graph_t *graph, char *name_1, char *name_2)
@@ -98,54 +121,35 @@ void common_friends(list_graph_t *graph, char *name_1, char *name_2)
 	int id_1 = get_user_id(name_1);
 	int id_2 = get_user_id(name_2);
 
-	int *frequency = calloc(MAX_PEOPLE, sizeof(int));
-	DIE(!frequency, "calloc failed\n");
-
-	linked_list_t *friends_list_1 = lg_get_neighbours(graph, id_1);
-	linked_list_t *friends_list_2 = lg_get_neighbours(graph, id_2);
-
-	ll_node_t *current_friend_1 = friends_list_1->head;
-	while (current_friend_1) {
-		frequency[*(int *)current_friend_1->data] = 1;
-		current_friend_1 = current_friend_1->next;
-	}
-
-	ll_node_t *current_friend_2 = friends_list_2->head;
-	while (current_friend_2) {
-		if (frequency[*(int *)current_friend_2->data] == 1)
-			frequency[*(int *)current_friend_2->data] = 2;
-		current_friend_2 = current_friend_2->next;
-	}
+	int n_friends_1, n_friends_2;
+	const int *friends_1 = lg_neighbours(graph, id_1, &n_friends_1);
+	const int *friends_2 = lg_neighbours(graph, id_2, &n_friends_2);
 
-	int have_common_friends = 0;
+	/* Both friend lists are sorted, so a merge gives the ids in order */
+	unsigned int i = 0, j = 0;
+	int common = next_common(friends_1, n_friends_1, &i,
+							 friends_2, n_friends_2, &j);
 
-	for (int i = 0; i < MAX_PEOPLE; i++) {
-		if (frequency[i] == 2) {
-			have_common_friends = 1;
-			break;
-		}
-	}
-
-	if (have_common_friends == 0) {
+	if (common == -1) {
 		printf("No common friends for %s and %s\n", name_1, name_2);
-		free(frequency);
 		return;
 	}
 	printf("The common friends between %s and %s are:\n", name_1, name_2);
 
-	for (int i = 0; i < MAX_PEOPLE; i++) {
-		if (frequency[i] == 2)
-			printf("%s\n", get_user_name(i));
+	while (common != -1) {
+		printf("%s\n", get_user_name(common));
+		common = next_common(friends_1, n_friends_1, &i,
+							 friends_2, n_friends_2, &j);
 	}
-	free(frequency);
 }
 
 void count_friends(list_graph_t *graph, char *name)
 {
 	int id = get_user_id(name);
 
-	linked_list_t *friends_list = lg_get_neighbours(graph, id);
-	int num_friends =  ll_get_size(friends_list);
+	int num_friends;
+
+	lg_neighbours(graph, id, &num_friends);
 	printf("%s has %d friends\n", name, num_friends);
 }
 
@@ -153,28 +157,26 @@ void most_popular_friend(list_graph_t *graph, char *name)
 {
 	int id = get_user_id(name);
 
-	linked_list_t *friends_list = lg_get_neighbours(graph, id);
-	int num_friends =  ll_get_size(friends_list);
+	int num_friends;
+	const int *friends = lg_neighbours(graph, id, &num_friends);
 	int max_num_friends = num_friends;
 	int max_id = id;
 
-	ll_node_t *current_friend = friends_list->head;
-	while (current_friend) {
-		linked_list_t *friends_of_friends_list =
-		lg_get_neighbours(graph, *(int *)current_friend->data);
-		int num_friends_of_friends =  ll_get_size(friends_of_friends_list);
+	for (int i = 0; i < num_friends; i++) {
+		int num_friends_of_friends;
+
+		lg_neighbours(graph, friends[i], &num_friends_of_friends);
 		if (num_friends_of_friends > max_num_friends) {
 			max_num_friends = num_friends_of_friends;
-			max_id = *(int *)current_friend->data;
+			max_id = friends[i];
 		} else {
 			if (num_friends_of_friends == max_num_friends) {
-				if (*(int *)current_friend->data < max_id) {
+				if (friends[i] < max_id) {
 					max_num_friends = num_friends_of_friends;
-					max_id = *(int *)current_friend->data;
+					max_id = friends[i];
 				}
 			}
 		}
-		current_friend = current_friend->next;
 	}
 	if (num_friends == max_num_friends)
 		printf("%s is the most popular\n", name);
@@ -2,7 +2,6 @@
 #define FRIENDS_H
 
 #define MAX_COMMAND_LEN 500
-#define MAX_PEOPLE 550
 
 #include "graph.h"
 
@@ -37,13 +36,13 @@ void remove_friend(list_graph_t *graph, char *name_1, char *name_2);
  * @brief Suggests new friends for a user based on the friends of
  * their friends.
  * Get the ID for the user's name
- * Create and initialize an array to keep track of the frequency
- * of potential friend suggestions.
  * Retrieve the list of friends for the user.
- * For each friend, retrieve their friends and mark potential friend
- * suggestions in the frequency array.
- * Exclude the user and their current friends from the suggestions.
- * If there are suggestions, print them;
+ * In the query workspace, mark the user and their friends with -1, then
+ * mark every friend of a friend that is not marked yet with 1. The marked
+ * users are in the touched list of the workspace, so only they are
+ * checked: the ones marked with 1 are the suggestions, without duplicates.
+ * Sort them by id with qsort.
+ * If there are suggestions, print them in id order;
  * otherwise, indicate that there are no suggestions.
  * @param graph The graph representing the network.
  * @param name The name of the user to suggest friends for.
@@ -67,16 +66,11 @@ void get_distance(list_graph_t *graph, char *name_1, char *name_2);
 /**
  * @brief Finds and prints the common friends between two users.
  * Get the unique identifiers for the two users based on their names.
- * Create and initialize an array to keep track of friend relationships.
- * Retrieve the friends lists for both users from the graph.
- * Traverse the friends list of the first user and mark them in
- * the frequency array.
- * Traverse the friends list of the second user and update the frequency
- * array for common friends.
- *  Determine if there are any common friends. (frequency[i] == 2)
+ * Retrieve the friends lists for both users from the graph. Both lists are
+ * sorted by id, so the common friends are found with a merge, in which the
+ * side that is behind gallops towards the other one.
  * Print the common friends if any, otherwise indicate that there
  * are no common friends.
- * Free the allocated memory for the frequency array.
  *
  * @param graph The graph representing the network.
  * @param name_1 The name of the first user.
@@ -87,8 +81,8 @@ void common_friends(list_graph_t *graph, char *name_1, char *name_2);
 /**
  * @brief Counts and prints the number of friends a user has.
  * Get the unique identifier for the user based on their name.
- * Retrieve the friends list for the user from the graph.
- * Count the number of friends in the list (ll_get_size(friends_list)).
+ * Get the number of friends of the user, the length of their row in the
+ * CSR snapshot of the graph (see lg_neighbours()), in O(1).
  * Print the user's name along with the number of friends they have.
  *
  * @param graph The graph representing the network.
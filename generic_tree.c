@@ -5,21 +5,212 @@
 
 #include "generic_tree.h"
 
-info *create_info(int id, int user_id, char *title)
+/* id -> (tree, node) index of every node of every tree */
+static g_index_entry_t *g_index;
+static int g_index_capacity;
+
+/* Freed tree structures, reused so that stale index entries stay readable */
+static g_tree_t **free_trees;
+static int n_free_trees, free_trees_capacity;
+static unsigned int next_tree_serial = 1;
+
+/* Frame of a walk: a node and the position of its next child to visit */
+typedef struct {
+	g_node_t *node;
+	int next_child;
+} g_walk_frame_t;
+
+/* Explicit stack of g_tree_walk(), kept between the walks */
+static g_walk_frame_t *walk_stack;
+static int walk_stack_capacity;
+static int walk_stack_busy;
+
+static void g_index_add(g_tree_t *tree, g_node_t *node)
+{
+	int id = ((info *)node->data)->id;
+
+	if (id >= g_index_capacity) {
+		int capacity = g_index_capacity ? g_index_capacity : 64;
+
+		while (capacity <= id)
+			capacity *= 2;
+
+		g_index = realloc(g_index, capacity * sizeof(*g_index));
+		DIE(!g_index, "realloc index failed");
+		memset(g_index + g_index_capacity, 0,
+			   (capacity - g_index_capacity) * sizeof(*g_index));
+		g_index_capacity = capacity;
+	}
+
+	g_index[id].tree = tree;
+	g_index[id].node = node;
+	g_index[id].serial = tree->serial;
+}
+
+static void g_index_remove(g_node_t *node)
+{
+	int id = ((info *)node->data)->id;
+
+	if (id >= 0 && id < g_index_capacity && g_index[id].node == node) {
+		g_index[id].tree = NULL;
+		g_index[id].node = NULL;
+	}
+}
+
+g_node_t *g_index_lookup(int id, g_tree_t **tree)
+{
+	if (id < 0 || id >= g_index_capacity || !g_index[id].node)
+		return NULL;
+
+	if (g_index[id].tree->serial != g_index[id].serial) {
+		/* The tree was freed after the node was added */
+		g_index[id].tree = NULL;
+		g_index[id].node = NULL;
+		return NULL;
+	}
+
+	if (tree)
+		*tree = g_index[id].tree;
+
+	return g_index[id].node;
+}
+
+void free_g_index(void)
+{
+	free(g_index);
+	g_index = NULL;
+	g_index_capacity = 0;
+
+	while (n_free_trees)
+		free(free_trees[--n_free_trees]);
+	free(free_trees);
+	free_trees = NULL;
+	free_trees_capacity = 0;
+
+	free(walk_stack);
+	walk_stack = NULL;
+	walk_stack_capacity = 0;
+}
+
+int g_tree_walk(g_node_t *root, g_visit_fn pre, g_visit_fn post, void *arg)
+{
+	if (!root)
+		return 0;
+
+	/* A walk started by a visitor of another walk gets its own stack */
+	int shared = !walk_stack_busy;
+	g_walk_frame_t *stack = shared ? walk_stack : NULL;
+	int capacity = shared ? walk_stack_capacity : 0;
+	int size = 0, stopped = 0;
+	g_node_t *next = root;
+
+	walk_stack_busy = 1;
+	while (!stopped && (next || size)) {
+		if (next) {
+			/* The level of a node is the number of frames below it */
+			if (pre && pre(next, size, arg)) {
+				stopped = 1;
+				break;
+			}
+			if (size == capacity) {
+				capacity = capacity ? 2 * capacity : 64;
+				stack = realloc(stack, capacity * sizeof(*stack));
+				DIE(!stack, "realloc walk stack failed");
+			}
+			stack[size].node = next;
+			stack[size++].next_child = 0;
+			next = NULL;
+			continue;
+		}
+
+		g_walk_frame_t *top = &stack[size - 1];
+
+		if (top->next_child < top->node->n_children) {
+			next = top->node->children[top->next_child++];
+			/* Start loading the sibling visited after this subtree */
+			if (top->next_child < top->node->n_children)
+				__builtin_prefetch(top->node->children[top->next_child]);
+		} else {
+			/* The visitor may free the node, it is not used after */
+			size--;
+			if (post && post(top->node, size, arg))
+				stopped = 1;
+		}
+	}
+
+	if (shared) {
+		walk_stack = stack;
+		walk_stack_capacity = capacity;
+		walk_stack_busy = 0;
+	} else {
+		free(stack);
+	}
+
+	return stopped;
+}
+
+static g_tree_t *alloc_tree(void)
+{
+	g_tree_t *g_tree;
+
+	if (n_free_trees) {
+		g_tree = free_trees[--n_free_trees];
+	} else {
+		g_tree = calloc(1, sizeof(g_tree_t));
+		DIE(!g_tree, "calloc failed");
+	}
+	g_tree->serial = next_tree_serial++;
+
+	return g_tree;
+}
+
+static void release_tree(g_tree_t *g_tree)
+{
+	if (n_free_trees == free_trees_capacity) {
+		free_trees_capacity = free_trees_capacity ?
+							  2 * free_trees_capacity : 16;
+		free_trees = realloc(free_trees,
+							 free_trees_capacity * sizeof(*free_trees));
+		DIE(!free_trees, "realloc failed");
+	}
+
+	/* Serial 0 never matches an index entry */
+	memset(g_tree, 0, sizeof(*g_tree));
+	free_trees[n_free_trees++] = g_tree;
+}
+
+static void *tree_alloc(g_tree_t *g_tree, size_t size)
+{
+	if (g_tree->use_arena)
+		return arena_alloc(&g_tree->arena, size);
+
+	void *memory = calloc(1, size);
+
+	DIE(!memory, "calloc failed");
+	return memory;
+}
+
+info *create_info(g_tree_t *g_tree, int id, int user_id, char *title)
 {
 	info *new_info = malloc(sizeof(info));
+	DIE(!new_info, "malloc failed");
 	new_info->id = id;
 	new_info->user_id = user_id;
+	new_info->n_likes = 0;
+	new_info->max_likes = 0;
+	new_info->max_likes_id = id;
+
+	if (g_tree && g_tree->use_arena) {
+		new_info->title = title ? arena_strdup(&g_tree->arena, title) : NULL;
+		ls_init(&new_info->likes, &g_tree->arena);
+		return new_info;
+	}
+
 	if (!title)
 		new_info->title = NULL;
 	else
 		new_info->title = strdup(title);
-	new_info->n_likes = 0;
-	new_info->likes =  calloc(1, sizeof(linked_list_t));
-	DIE(!new_info->likes, "calloc failed\n");
-	new_info->likes->head = NULL;
-	new_info->likes->size = 0;
-	new_info->likes->data_size = sizeof(int);
+	ls_init(&new_info->likes, NULL);
 	return new_info;
 }
 
@@ -27,50 +218,116 @@ void free_value_post(void *data)
 {
 	if (((info *)data)->title)
 		free(((info *)data)->title);
-	if (((info *)data))
-		ll_free(&(((info *)data)->likes));
+	ls_free(&((info *)data)->likes);
 	free(data);
 }
 
 g_tree_t *init_generic_tree(int data_size, void (*free_value_function)(void *),
-							int max_size)
+							int initial_children)
 {
-	g_tree_t *g_tree = calloc(1, sizeof(g_tree_t));
-	DIE(!g_tree, "calloc failed");
+	g_tree_t *g_tree = alloc_tree();
 
 	g_tree->root = NULL;
 	g_tree->data_size = data_size;
 	g_tree->size = 0;
 	g_tree->free_value = free_value_function;
-	g_tree->max_size = max_size;
+	g_tree->initial_children = initial_children;
 
 	return g_tree;
 }
 
-g_node_t *search_node_recursive(g_node_t *node, int parent_id) {
-	if (!node)
-		return NULL;
+g_tree_t *init_generic_tree_in_arena(int data_size, int initial_children)
+{
+	g_tree_t *g_tree = init_generic_tree(data_size, NULL, initial_children);
 
-	if (((info *)node->data)->id == parent_id)
-		return node;
+	g_tree->use_arena = 1;
+	arena_init(&g_tree->arena);
 
-	for (int i = 0; i < node->n_children; i++) {
-		g_node_t *found_node = search_node_recursive(node->children[i],
-													 parent_id);
-		if (found_node)
-			return found_node;
-	}
+	return g_tree;
+}
+
+typedef struct {
+	int id; /* ID to search for. */
+	g_node_t *found; /* Node with the ID, NULL until it is found. */
+} search_walk_t;
+
+static int search_visit(g_node_t *node, int level, void *arg)
+{
+	search_walk_t *search = arg;
 
-	return NULL;
+	(void)level;
+	if (((info *)node->data)->id != search->id)
+		return 0;
+
+	search->found = node;
+	return 1;
+}
+
+g_node_t *search_node_recursive(g_node_t *node, int parent_id) {
+	search_walk_t search = {parent_id, NULL};
+
+	g_tree_walk(node, search_visit, NULL, &search);
+
+	return search.found;
 }
 
 g_node_t *search_node(g_tree_t *g_tree, int parent_id) {
 	if (!g_tree || !g_tree->root)
 		return NULL;
-	return search_node_recursive(g_tree->root, parent_id);
+
+	g_tree_t *tree = NULL;
+	g_node_t *node = g_index_lookup(parent_id, &tree);
+
+	return tree == g_tree ? node : NULL;
+}
+
+static void add_child(g_tree_t *g_tree, g_node_t *parent, g_node_t *child)
+{
+	if (parent->n_children == parent->children_capacity) {
+		int capacity = parent->children_capacity ?
+					   2 * parent->children_capacity : MIN_CHILDREN;
+		size_t size = capacity * sizeof(*parent->children);
+
+		if (g_tree->use_arena) {
+			/* The old array stays in the arena until the tree is freed */
+			g_node_t **children = arena_alloc(&g_tree->arena, size);
+
+			if (parent->n_children)
+				memcpy(children, parent->children,
+					   parent->n_children * sizeof(*children));
+			parent->children = children;
+		} else {
+			parent->children = realloc(parent->children, size);
+			DIE(!parent->children, "realloc failed");
+		}
+		parent->children_capacity = capacity;
+	}
+
+	parent->children[parent->n_children++] = child;
+}
+
+static g_node_t *create_tree_node(g_tree_t *g_tree, void *data)
+{
+	if (!g_tree->use_arena)
+		return create_node(data, g_tree->data_size,
+						   g_tree->initial_children);
+
+	g_node_t *g_node = arena_alloc(&g_tree->arena, sizeof(*g_node));
+
+	if (g_tree->initial_children > 0) {
+		size_t size = g_tree->initial_children * sizeof(*g_node->children);
+
+		g_node->children = arena_alloc(&g_tree->arena, size);
+		g_node->children_capacity = g_tree->initial_children;
+	}
+
+	g_node->data = arena_alloc(&g_tree->arena, g_tree->data_size);
+	memcpy(g_node->data, data, g_tree->data_size);
+
+	return g_node;
 }
 
-g_node_t *create_node(void *data, int data_size, int max_size)
+g_node_t *create_node(void *data, int data_size, int initial_children)
 {
 	g_node_t *g_node;
 
@@ -79,8 +336,11 @@ g_node_t *create_node(void *data, int data_size, int max_size)
 	DIE(!g_node, "g_node calloc");
 
 	g_node->n_children = 0;
-	g_node->children = calloc(max_size, sizeof(g_node_t *));
-	DIE(!g_node->children, "calloc failed");
+	if (initial_children > 0) {
+		g_node->children = calloc(initial_children, sizeof(g_node_t *));
+		DIE(!g_node->children, "calloc failed");
+		g_node->children_capacity = initial_children;
+	}
 
 	g_node->data = calloc(1, data_size);
 	DIE(!g_node->data, "g_node->data malloc");
@@ -89,39 +349,201 @@ g_node_t *create_node(void *data, int data_size, int max_size)
 	return g_node;
 }
 
+/* Returns 1 if likes and id beat the max likes of the subtree of data */
+static int beats_max_likes(int likes, int id, const info *data)
+{
+	if (likes != data->max_likes)
+		return likes > data->max_likes;
+	return id < data->max_likes_id;
+}
+
+/* Passes a new max of likes and id of a subtree up from node */
+static void raise_max_likes(g_node_t *node, int likes, int id)
+{
+	for (; node; node = node->parent) {
+		info *data = node->data;
+
+		if (!beats_max_likes(likes, id, data))
+			return;
+		data->max_likes = likes;
+		data->max_likes_id = id;
+	}
+}
+
+/* Recomputes the max likes of node from its likes and its children */
+static void recompute_max_likes(g_node_t *node)
+{
+	info *data = node->data;
+
+	data->max_likes = data->n_likes;
+	data->max_likes_id = data->id;
+	for (int i = 0; i < node->n_children; i++) {
+		info *child = node->children[i]->data;
+
+		if (beats_max_likes(child->max_likes, child->max_likes_id, data)) {
+			data->max_likes = child->max_likes;
+			data->max_likes_id = child->max_likes_id;
+		}
+	}
+}
+
+/* Recomputes the ancestors that got their max from likes and id of node */
+static void drop_max_likes(g_node_t *node, int likes, int id)
+{
+	for (; node; node = node->parent) {
+		info *data = node->data;
+
+		if (data->max_likes != likes || data->max_likes_id != id)
+			return;
+		recompute_max_likes(node);
+	}
+}
+
+void update_max_likes(g_node_t *node, int old_n_likes)
+{
+	info *data = node->data;
+
+	if (data->n_likes > old_n_likes)
+		raise_max_likes(node, data->n_likes, data->id);
+	else if (data->n_likes < old_n_likes)
+		drop_max_likes(node, old_n_likes, data->id);
+}
+
+/* Relabels the tags around tag so that there is a gap after it */
+static void relabel_tags(g_tag_t *tag)
+{
+	g_tag_t *first = tag, *last = tag;
+	double max_tags = 1;
+	int count = 1;
+
+	for (int i = 1; i <= G_LABEL_BITS; i++) {
+		unsigned long long size = 1ULL << i;
+		unsigned long long first_label = tag->label & ~(size - 1);
+
+		/* The block of level i contains the block of level i - 1 */
+		max_tags *= 2 / G_RELABEL_DENSITY;
+		while (first->prev && first->prev->label >= first_label) {
+			first = first->prev;
+			count++;
+		}
+		while (last->next && last->next->label - first_label < size) {
+			last = last->next;
+			count++;
+		}
+
+		/* Room for the new tag too */
+		if (count + 1 > max_tags || size < 8ULL * (count + 1))
+			continue;
+
+		/*
+		 * The next tags are likely to go into the same gap (a chain or a
+		 * fan keeps growing at the same place), so it gets half of the
+		 * block and the other tags share the rest evenly.
+		 */
+		unsigned long long label = first_label;
+		unsigned long long gap = size / 4 / count;
+
+		for (g_tag_t *it = first; it != last->next; it = it->next) {
+			it->label = label;
+			label += it == tag ? size / 2 : gap;
+		}
+		return;
+	}
+
+	DIE(1, "too many tags to label");
+}
+
+/* Links tag right after prev, in the middle of the gap between them */
+static void insert_tag_after(g_tag_t *prev, g_tag_t *tag)
+{
+	unsigned long long end = 1ULL << G_LABEL_BITS;
+
+	if ((prev->next ? prev->next->label : end) - prev->label < 2)
+		relabel_tags(prev);
+
+	unsigned long long next_label = prev->next ? prev->next->label : end;
+
+	tag->label = prev->label + (next_label - prev->label) / 2;
+	tag->prev = prev;
+	tag->next = prev->next;
+	if (prev->next)
+		prev->next->prev = tag;
+	prev->next = tag;
+}
+
+int g_node_in_subtree(const g_node_t *node, const g_node_t *ancestor)
+{
+	return ancestor->enter.label <= node->enter.label &&
+		   node->enter.label < ancestor->exit.label;
+}
+
+int g_subtree_scan(g_node_t *root, g_visit_fn visit, void *arg)
+{
+	if (!root)
+		return 0;
+
+	for (g_tag_t *tag = &root->enter; ; tag = tag->next) {
+		g_node_t *node = tag->node;
+
+		if (tag == &node->enter &&
+			visit(node, node->depth - root->depth, arg))
+			return 1;
+		if (tag == &root->exit)
+			return 0;
+	}
+}
+
 void insert_node(g_tree_t *g_tree, void *data, int parent_id)
 {
-	g_node_t *new_node = create_node(data, g_tree->data_size, g_tree->max_size);
+	g_node_t *new_node = create_tree_node(g_tree, data);
 	g_tree->size++;
 
 	g_node_t *root = g_tree->root;
 
+	g_tree->euler_cache.dirty = 1;
+	g_tree->euler_cache.queries = 0;
+	g_index_add(g_tree, new_node);
+	new_node->enter.node = new_node;
+	new_node->exit.node = new_node;
 	if (!root) {
 		g_tree->root = new_node;
+		new_node->enter.label = 0;
+		insert_tag_after(&new_node->enter, &new_node->exit);
 		return;
 	}
 	g_node_t *parent_node = search_node(g_tree, parent_id);
-	parent_node->children[parent_node->n_children] = new_node;
-	parent_node->n_children++;
+	add_child(g_tree, parent_node, new_node);
+
+	/* The new node is the last child, its tags go before the parent exits */
+	insert_tag_after(parent_node->exit.prev, &new_node->enter);
+	insert_tag_after(&new_node->enter, &new_node->exit);
+
+	new_node->parent = parent_node;
+	new_node->depth = parent_node->depth + 1;
+
+	/* One jump per power of two that is not above the root */
+	while ((1 << new_node->n_jumps) <= new_node->depth)
+		new_node->n_jumps++;
+
+	new_node->jump = tree_alloc(g_tree,
+								new_node->n_jumps * sizeof(*new_node->jump));
+	new_node->jump[0] = parent_node;
+	for (int k = 1; k < new_node->n_jumps; k++)
+		new_node->jump[k] = new_node->jump[k - 1]->jump[k - 1];
+
+	raise_max_likes(parent_node, ((info *)new_node->data)->max_likes,
+					((info *)new_node->data)->max_likes_id);
 }
 
 g_node_t *get_the_parent_recursive(g_node_t *node, int node_id,
 								   g_node_t *parent)
 {
-	if (!node)
-		return NULL;
-
-	if (((info *)node->data)->id == node_id)
-		return parent;
+	g_node_t *found = search_node_recursive(node, node_id);
 
-	for (int i = 0; i < node->n_children; i++) {
-		g_node_t *found_parent =
-		get_the_parent_recursive(node->children[i], node_id, node);
-		if (found_parent)
-			return found_parent;
-	}
+	if (!found)
+		return NULL;
 
-	return NULL;
+	return found == node ? parent : found->parent;
 }
 
 g_node_t *get_the_parent(g_tree_t *tree, int node_id)
@@ -129,17 +551,59 @@ g_node_t *get_the_parent(g_tree_t *tree, int node_id)
 	if (!tree || !tree->root)
 		return NULL;
 
-	return get_the_parent_recursive(tree->root, node_id, NULL);
+	g_node_t *node = search_node(tree, node_id);
+
+	return node ? node->parent : NULL;
 }
 
-int count_tree_nodes_recursive(g_node_t *g_node) {
-	if (!g_node)
-		return 0;
+g_node_t *get_ancestor_at_depth(g_node_t *node, int depth)
+{
+	int diff = node->depth - depth;
 
-	int count = 1;
+	for (int k = 0; diff; k++, diff >>= 1) {
+		if (diff & 1)
+			node = node->jump[k];
+	}
 
-	for (int i = 0; i < g_node->n_children; i++)
-		count += count_tree_nodes_recursive(g_node->children[i]);
+	return node;
+}
+
+g_node_t *lowest_common_ancestor(g_node_t *node_1, g_node_t *node_2)
+{
+	if (node_1->depth > node_2->depth)
+		node_1 = get_ancestor_at_depth(node_1, node_2->depth);
+	else
+		node_2 = get_ancestor_at_depth(node_2, node_1->depth);
+
+	if (node_1 == node_2)
+		return node_1;
+
+	/*
+	 * Both nodes are on the same depth, so they have the same jumps. A lift
+	 * can leave them too close to the root for the next bigger jumps.
+	 */
+	for (int k = node_1->n_jumps - 1; k >= 0; k--) {
+		if (k < node_1->n_jumps && node_1->jump[k] != node_2->jump[k]) {
+			node_1 = node_1->jump[k];
+			node_2 = node_2->jump[k];
+		}
+	}
+
+	return node_1->parent;
+}
+
+static int count_visit(g_node_t *node, int level, void *arg)
+{
+	(void)node;
+	(void)level;
+	(*(int *)arg)++;
+	return 0;
+}
+
+int count_tree_nodes_recursive(g_node_t *g_node) {
+	int count = 0;
+
+	g_tree_walk(g_node, count_visit, NULL, &count);
 
 	return count;
 }
@@ -151,20 +615,27 @@ int count_tree_nodes(g_tree_t *g_tree) {
 	return count_tree_nodes_recursive(g_tree->root);
 }
 
-void delete_subtree_recursively(g_node_t *node,
-								void (*free_value_function)(void *))
+/* Frees a node after its children, in postorder */
+static int delete_visit(g_node_t *node, int level, void *arg)
 {
-	if (!node)
-		return;
-
-	for (int i = 0; i < node->n_children; ++i)
-		delete_subtree_recursively(node->children[i], free_value_function);
+	void (*free_value_function)(void *) = *(void (**)(void *))arg;
 
-	if (node->data)
+	(void)level;
+	if (node->data) {
+		g_index_remove(node);
 		free_value_function(node->data);
+	}
 
 	free(node->children);
+	free(node->jump);
 	free(node);
+	return 0;
+}
+
+void delete_subtree_recursively(g_node_t *node,
+								void (*free_value_function)(void *))
+{
+	g_tree_walk(node, NULL, delete_visit, &free_value_function);
 }
 
 void delete_subtree(g_tree_t *g_tree, int parent_id)
@@ -172,6 +643,9 @@ void delete_subtree(g_tree_t *g_tree, int parent_id)
 	if (!g_tree->root)
 		return;
 
+	g_tree->euler_cache.dirty = 1;
+	g_tree->euler_cache.queries = 0;
+
 	g_node_t *parent_of_parent = get_the_parent(g_tree, parent_id);
 	int pos;
 	g_node_t *parent_node;
@@ -188,8 +662,34 @@ void delete_subtree(g_tree_t *g_tree, int parent_id)
 	} else {
 		parent_node = g_tree->root;
 	}
-
-	delete_subtree_recursively(parent_node, g_tree->free_value);
+	int max_likes = ((info *)parent_node->data)->max_likes;
+	int max_likes_id = ((info *)parent_node->data)->max_likes_id;
+
+	/* Cut the range of tags of the subtree out of the preorder list */
+	g_tag_t *tag = &parent_node->enter, *end = &parent_node->exit;
+
+	if (tag->prev)
+		tag->prev->next = end->next;
+	if (end->next)
+		end->next->prev = tag->prev;
+
+	/* Then go through the range, which holds every node of the subtree */
+	while (tag) {
+		g_tag_t *next = tag == end ? NULL : tag->next;
+		g_node_t *node = tag->node;
+
+		if (tag == &node->enter) {
+			g_index_remove(node);
+			g_tree->size--;
+		} else if (!g_tree->use_arena) {
+			/* The exit tag comes after the whole subtree of the node */
+			g_tree->free_value(node->data);
+			free(node->children);
+			free(node->jump);
+			free(node);
+		}
+		tag = next;
+	}
 
 	if (parent_of_parent) {
 		if (pos != -1) {
@@ -200,28 +700,148 @@ void delete_subtree(g_tree_t *g_tree, int parent_id)
 			parent_of_parent->children[parent_of_parent->n_children - 1] = NULL;
 			parent_of_parent->n_children--;
 		}
+		drop_max_likes(parent_of_parent, max_likes, max_likes_id);
 
 	} else {
 		g_tree->root = NULL;
 	}
 }
 
-void free_g_tree(g_tree_t *g_tree)
+static int euler_enter(g_node_t *node, int level, void *arg)
 {
-	if (!g_tree->root) {
-		free(g_tree);
-		return;
+	euler_cache_t *cache = arg;
+
+	(void)level;
+	node->euler_index = cache->length;
+	cache->tour[cache->length] = node;
+	cache->level[cache->length++] = node->depth;
+	return 0;
+}
+
+/* The tour goes back to the parent after every child */
+static int euler_leave(g_node_t *node, int level, void *arg)
+{
+	euler_cache_t *cache = arg;
+
+	if (level == 0)
+		return 0;
+
+	cache->tour[cache->length] = node->parent;
+	cache->level[cache->length++] = node->parent->depth;
+	return 0;
+}
+
+static void euler_cache_build(g_tree_t *g_tree)
+{
+	euler_cache_t *cache = &g_tree->euler_cache;
+	int nodes = g_tree->size;
+	int length = 2 * nodes - 1;
+	int n_rows = 1;
+
+	while ((1 << n_rows) <= length)
+		n_rows++;
+
+	if (length > cache->capacity) {
+		free(cache->tour);
+		free(cache->level);
+		free(cache->sparse);
+		cache->tour = malloc(length * sizeof(*cache->tour));
+		cache->level = malloc(length * sizeof(*cache->level));
+		cache->sparse = malloc((size_t)n_rows * length *
+							   sizeof(*cache->sparse));
+		DIE(!cache->tour || !cache->level || !cache->sparse,
+			"malloc euler cache failed");
+		cache->capacity = length;
+	}
+	cache->n_rows = n_rows;
+
+	cache->length = 0;
+	g_tree_walk(g_tree->root, euler_enter, euler_leave, cache);
+
+	/* Row k is built from the two halves of each range in row k - 1 */
+	int *row = cache->sparse;
+
+	for (int i = 0; i < length; i++)
+		row[i] = i;
+	for (int k = 1; k < n_rows; k++) {
+		int *prev = row;
+
+		row += cache->capacity;
+		for (int i = 0; i + (1 << k) <= length; i++) {
+			int left = prev[i], right = prev[i + (1 << (k - 1))];
+
+			row[i] = cache->level[right] < cache->level[left] ? right : left;
+		}
 	}
 
-	delete_subtree(g_tree, ((info *)g_tree->root->data)->id);
-	free(g_tree);
+	cache->dirty = 0;
 }
 
-void print_tree_recursive(g_node_t *node, int level)
+g_node_t *euler_cache_lca(g_tree_t *g_tree, g_node_t *node_1,
+						  g_node_t *node_2)
 {
-	if (!node)
-		return;
+	euler_cache_t *cache = &g_tree->euler_cache;
+
+	if (cache->dirty || !cache->tour)
+		euler_cache_build(g_tree);
+
+	int left = node_1->euler_index, right = node_2->euler_index;
+
+	if (left > right) {
+		int aux = left;
+
+		left = right;
+		right = aux;
+	}
+
+	/* Two ranges of 2^k entries that cover [left, right] */
+	int k = 0;
+
+	while ((2 << k) <= right - left + 1)
+		k++;
+
+	int *row = cache->sparse + (size_t)k * cache->capacity;
+	int pos_1 = row[left], pos_2 = row[right - (1 << k) + 1];
+
+	return cache->tour[cache->level[pos_2] < cache->level[pos_1] ?
+					   pos_2 : pos_1];
+}
+
+g_node_t *tree_lca(g_tree_t *g_tree, g_node_t *node_1, g_node_t *node_2)
+{
+	euler_cache_t *cache = &g_tree->euler_cache;
+
+	if (g_node_in_subtree(node_2, node_1))
+		return node_1;
+	if (g_node_in_subtree(node_1, node_2))
+		return node_2;
 
+	if (!cache->dirty && cache->tour)
+		return euler_cache_lca(g_tree, node_1, node_2);
+
+	if (++cache->queries * EULER_CACHE_NODES_PER_QUERY >= g_tree->size)
+		return euler_cache_lca(g_tree, node_1, node_2);
+
+	return lowest_common_ancestor(node_1, node_2);
+}
+
+void free_g_tree(g_tree_t *g_tree)
+{
+	free(g_tree->euler_cache.tour);
+	free(g_tree->euler_cache.level);
+	free(g_tree->euler_cache.sparse);
+
+	if (g_tree->use_arena)
+		arena_release(&g_tree->arena);
+	else if (g_tree->root)
+		delete_subtree(g_tree, ((info *)g_tree->root->data)->id);
+
+	release_tree(g_tree);
+}
+
+static int print_visit(g_node_t *node, int level, void *arg)
+{
+	level += *(int *)arg;
 	if (level == 0) {
 		printf("%s - Post by %s\n", ((info *)node->data)->title,
 			   get_user_name(((info *)node->data)->user_id));
@@ -229,8 +849,12 @@ void print_tree_recursive(g_node_t *node, int level)
 		printf("Repost #%d by %s\n", ((info *)node->data)->id,
 			   get_user_name(((info *)node->data)->user_id));
 	}
-	for (int i = 0; i < node->n_children; i++)
-		print_tree_recursive(node->children[i], level + 1);
+	return 0;
+}
+
+void print_tree_recursive(g_node_t *node, int level)
+{
+	g_subtree_scan(node, print_visit, &level);
 }
 
 void print_generic_tree(g_tree_t *g_tree)
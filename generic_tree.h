@@ -7,20 +7,82 @@
 #include <errno.h>
 #include "users.h"
 #include "graph.h"
+#include "arena.h"
+#include "like_set.h"
 
-#define MAX_CHILDREN 100
+/* Number of child slots allocated for the first child of a node */
+#define MIN_CHILDREN 1
+
+/*
+ * The Euler tour cache of a tree is built once it got at least one LCA
+ * query per EULER_CACHE_NODES_PER_QUERY nodes since its last change.
+ */
+#define EULER_CACHE_NODES_PER_QUERY 1
+
+/* Labels of the preorder tags are below 2^G_LABEL_BITS */
+#define G_LABEL_BITS 62
+/*
+ * A relabeled block of 2^i labels holds at most (2 / G_RELABEL_DENSITY)^i
+ * tags, so the tags get sparser as the blocks get bigger.
+ */
+#define G_RELABEL_DENSITY 1.4
+
+typedef struct g_node_t g_node_t;
+
+/**
+ * @brief Tag of a node in the preorder list of its tree. Every node has an
+ * enter tag before the tags of its subtree and an exit tag after them, so
+ * the subtree of a node is the range between its two tags. The labels grow
+ * along the list and leave gaps, so a new tag usually gets the middle of the
+ * gap it goes into. When there is no gap left, the smallest aligned block of
+ * labels around it that is sparse enough is relabeled, which keeps the
+ * amortized cost of an insertion O(log n).
+ */
+typedef struct g_tag_t g_tag_t;
+struct g_tag_t
+{
+	unsigned long long label; /* Position of the tag in the order. */
+	g_tag_t *prev; /* Previous tag in preorder, NULL for the first one. */
+	g_tag_t *next; /* Next tag in preorder, NULL for the last one. */
+	g_node_t *node; /* Node that is entered or exited at this tag. */
+};
 
 /**
  * @brief Structure representing a node in the generic tree.
  */
-typedef struct g_node_t g_node_t;
 struct g_node_t
 {
 	void *data; /* Pointer to the data stored in the node. */
-	g_node_t **children; /* Array of pointers to child nodes. */
+	g_node_t **children; /* Array of pointers to child nodes, NULL for a
+	node without children. It doubles when it is full. */
 	int n_children; /* Number of children nodes. */
+	int children_capacity; /* Number of slots in children. */
+	g_node_t *parent; /* Parent node, NULL for the root. */
+	int depth; /* Number of edges between the node and the root. */
+	g_node_t **jump; /* jump[k] is the ancestor 2^k levels above. */
+	int n_jumps; /* Number of entries in jump. */
+	int euler_index; /* First position in the Euler tour cache. */
+	g_tag_t enter; /* Tag before the subtree in the preorder list. */
+	g_tag_t exit; /* Tag after the subtree in the preorder list. */
 };
 
+/**
+ * @brief Cached Euler tour of a tree with a sparse table over the levels of
+ * the tour, which answers LCA queries in O(1). It is rebuilt lazily, on the
+ * first query after the tree changed.
+ */
+typedef struct {
+	g_node_t **tour; /* Nodes in the order of the Euler tour. */
+	int *level; /* Depth of every node of the tour. */
+	int length; /* Number of entries in the tour (2 * nodes - 1). */
+	int *sparse; /* Row k holds the position of the minimum level of
+	every range of 2^k entries of the tour. */
+	int n_rows; /* Number of rows of the sparse table. */
+	int capacity; /* Number of entries allocated per array / row. */
+	int dirty; /* 1 if the tree changed since the last build. */
+	int queries; /* LCA queries since the tree last changed. */
+} euler_cache_t;
+
 /**
  * @brief Structure representing the generic tree.
  */
@@ -32,9 +94,26 @@ struct g_tree_t
 	int size; /* Total number of nodes in the tree. */
 	void (*free_value)(void *value); /* Function pointer to free
 	the data in each node. */
-	int max_size; /* Maximum number of children nodes. */
+	int initial_children; /* Child slots allocated with each node. */
+	euler_cache_t euler_cache; /* Cached Euler tour used for LCA queries. */
+	int use_arena; /* 1 if the nodes and their data live in arena. */
+	arena_t arena; /* Memory of the nodes, freed at once with the tree. */
+	unsigned int serial; /* Unique number of the tree, 0 once freed. */
 };
 
+/**
+ * @brief Entry of the index that maps the id of a node (post or repost)
+ * to the node and the tree that holds it. The ids are handed out by a
+ * single counter, so the index is an array addressed by id.
+ */
+typedef struct {
+	g_tree_t *tree; /* Tree that holds the node. */
+	g_node_t *node; /* Node with this id, or NULL if there is none. */
+	unsigned int serial; /* Serial of the tree when the node was added.
+	Freeing a tree changes its serial, which invalidates all its entries
+	without visiting them. */
+} g_index_entry_t;
+
 /**
  * @brief Structure representing information stored in the tree nodes.
  */
@@ -42,19 +121,26 @@ typedef struct {
 	int id; /* ID of the info. */
 	int user_id; /* User ID associated with the info. */
 	char *title; /* Title of the info. */
-	linked_list_t *likes; /*Linked list of likes. */
-	int n_likes; /* Number of likes. */
+	like_set_t likes; /* Set of the ids of the users who liked it. */
+	int n_likes; /* Number of likes, always the size of likes. */
+	int max_likes; /* Most likes of a node in the subtree of this node. */
+	int max_likes_id; /* Smallest ID of a node of the subtree with
+	max_likes likes. */
 } info;
 
 /**
  * @brief Creates an info structure with the given id, user_id, and title.
+ * The info itself is allocated with malloc, to be copied by insert_node().
+ * If the tree has an arena, the title and the like set are allocated in
+ * it.
  *
+ * @param g_tree The tree that will hold the info.
  * @param id The ID of the info.
  * @param user_id The user ID associated with the info.
  * @param title The title of the info. Can be NULL.
  * @return A pointer to the created info structure.
  */
-info *create_info(int id, int user_id, char *title);
+info *create_info(g_tree_t *g_tree, int id, int user_id, char *title);
 
 /**
  * @brief Frees the memory allocated for an info structure.
@@ -68,14 +154,74 @@ void free_value_post(void *data);
  *
  * @param data_size The size of the data to be stored in each node.
  * @param free_value_function Function to free the data in each node.
- * @param max_size The maximum number of children for each node.
+ * @param initial_children The number of child slots allocated with each
+ * node. With 0, the slots are only allocated when the first child is added.
+ * A node can have any number of children.
  * @return A pointer to the created generic tree.
  */
 g_tree_t *init_generic_tree(int data_size,
-							void (*free_value_function)(void *), int max_size);
+							void (*free_value_function)(void *),
+							int initial_children);
 
 /**
- * @brief Recursively searches for a node with the given parent_id.
+ * @brief Initializes a generic tree whose nodes, child arrays, jump tables
+ * and data are allocated from an arena of the tree. Deleting a subtree
+ * only unlinks it; its memory is freed with the whole tree, by a single
+ * arena release.
+ *
+ * @param data_size The size of the data to be stored in each node.
+ * @param initial_children The number of child slots allocated with each
+ * node.
+ * @return A pointer to the created generic tree.
+ */
+g_tree_t *init_generic_tree_in_arena(int data_size, int initial_children);
+
+/**
+ * @brief Looks up a node by its id in the index of all the trees, in O(1).
+ * The index is kept up to date by insert_node() and delete_subtree().
+ *
+ * @param id The ID of the node.
+ * @param tree Where to store the tree that holds the node. Can be NULL.
+ * @return A pointer to the node, or NULL if no live node has this ID.
+ */
+g_node_t *g_index_lookup(int id, g_tree_t **tree);
+
+/**
+ * @brief Frees the index of all the trees, the tree structures kept for
+ * reuse and the stack of g_tree_walk(). Every tree must be freed before.
+ */
+void free_g_index(void);
+
+/**
+ * @brief Visitor of g_tree_walk().
+ *
+ * @param node The visited node.
+ * @param level The depth of the node below the root of the walk.
+ * @param arg The argument given to g_tree_walk().
+ * @return 0 to go on with the walk, any other value to stop it.
+ */
+typedef int (*g_visit_fn)(g_node_t *node, int level, void *arg);
+
+/**
+ * @brief Walks the subtree of a node depth first, children in order,
+ * without recursion: the path from the root of the walk to the current node
+ * is kept on an explicit stack, so a chain of any depth only costs one
+ * frame of 16 bytes per level. The stack is kept for the next walk, except
+ * for a walk started by a visitor, which gets its own.
+ *
+ * @param root The root of the walk. Can be NULL.
+ * @param pre Called on every node before its children (preorder). Can be
+ * NULL.
+ * @param post Called on every node after its children (postorder). The node
+ * is not used by the walk afterwards, so it can be freed. Can be NULL.
+ * @param arg Passed to the visitors.
+ * @return 1 if a visitor stopped the walk, 0 otherwise.
+ */
+int g_tree_walk(g_node_t *root, g_visit_fn pre, g_visit_fn post, void *arg);
+
+/**
+ * @brief Searches the subtree of a node for the node with the given
+ * parent_id, in preorder, with g_tree_walk().
  *
  * @param node The node to start the search from.
  * @param parent_id The ID of the parent to search for.
@@ -85,6 +231,7 @@ g_node_t *search_node_recursive(g_node_t *node, int parent_id);
 
 /**
  * @brief Searches for a node with the given parent_id in the generic tree.
+ * The node is found through the id index, in O(1).
  *
  * @param tree The generic tree to search in.
  * @param parent_id The ID of the parent to search for.
@@ -97,23 +244,38 @@ g_node_t *search_node(g_tree_t *tree, int parent_id);
  *
  * @param data The data to be stored in the node.
  * @param data_size The size of the data.
- * @param max_size The maximum number of children for the node.
+ * @param initial_children The number of child slots to allocate.
  * @return A pointer to the created node.
  */
-g_node_t *create_node(void *data, int data_size, int max_size);
+g_node_t *create_node(void *data, int data_size, int initial_children);
 
 /**
- * @brief Inserts a new node with the given data into the generic tree.
+ * @brief Inserts a new node with the given data into the generic tree and
+ * adds it to the id index. The parent, the depth and the jump table of the
+ * new node are set from its parent, and its max likes are passed up to its
+ * ancestors.
  *
  * @param g_tree The generic tree to insert the node into.
  * @param data The data to be stored in the new node.
  * @param node The ID of the parent node to insert under.
- * @param max_size The maximum number of children for the new node.
  */
 void insert_node(g_tree_t *g_tree, void *data, int node);
 
 /**
- * @brief Recursively searches for the parent of a node with the given node_id.
+ * @brief Updates the max likes of a node and of its ancestors after the
+ * number of likes of the node changed. A new like only goes up while it
+ * beats the max likes of the ancestors. A removed like only recomputes, from
+ * the children, the ancestors whose max likes came from the node, so the
+ * cost is bounded by the depth times the number of children.
+ *
+ * @param node The node whose number of likes changed.
+ * @param old_n_likes The number of likes of the node before the change.
+ */
+void update_max_likes(g_node_t *node, int old_n_likes);
+
+/**
+ * @brief Searches the subtree of a node for the parent of the node with the
+ * given node_id, with g_tree_walk().
  *
  * @param node The node to start the search from.
  * @param node_id The ID of the node to find the parent of.
@@ -125,6 +287,8 @@ g_node_t *get_the_parent_recursive(g_node_t *node, int node_id,
 
 /**
  * @brief Gets the parent of a node with the given node_id in the generic tree.
+ * The node is found through the id index and knows its parent, so this is
+ * O(1).
  *
  * @param tree The generic tree to search in.
  * @param node_id The ID of the node to find the parent of.
@@ -133,14 +297,85 @@ g_node_t *get_the_parent_recursive(g_node_t *node, int node_id,
 g_node_t *get_the_parent(g_tree_t *tree, int node_id);
 
 /**
- * @brief Counts the number of nodes in a subtree recursively.
- * Base Case: If the current node is NULL, the function returns 0,
- * indicating that there are no nodes.
- * For each node, increment the count by 1, representing the current node.
- * Recursively call the function for each child node and add their counts
- * to the total count.
- * After processing all children, return the total count, which represents
- * the number of nodes in the tree.
+ * @brief Gets the ancestor of a node that is on the given depth, using the
+ * jump table of the nodes, in O(log depth).
+ *
+ * @param node The node.
+ * @param depth The depth of the ancestor (at most the depth of the node).
+ * @return A pointer to the ancestor (the node itself for its own depth).
+ */
+g_node_t *get_ancestor_at_depth(g_node_t *node, int depth);
+
+/**
+ * @brief Finds the lowest common ancestor of two nodes of the same tree
+ * with binary lifting, in O(log depth).
+ * The deeper node is lifted to the depth of the other one. Then both nodes
+ * are lifted by the biggest powers of two that keep them apart, from the
+ * biggest to the smallest, so they end up right below their LCA.
+ *
+ * @param node_1 The first node.
+ * @param node_2 The second node.
+ * @return A pointer to the lowest common ancestor.
+ */
+g_node_t *lowest_common_ancestor(g_node_t *node_1, g_node_t *node_2);
+
+/**
+ * @brief Finds the lowest common ancestor of two nodes with the Euler tour
+ * cache of the tree, rebuilding the cache first if the tree changed.
+ * The LCA is the node with the minimum level between the first positions of
+ * the two nodes in the tour, found with two lookups in the sparse table.
+ *
+ * @param g_tree The tree that holds both nodes.
+ * @param node_1 The first node.
+ * @param node_2 The second node.
+ * @return A pointer to the lowest common ancestor.
+ */
+g_node_t *euler_cache_lca(g_tree_t *g_tree, g_node_t *node_1,
+						  g_node_t *node_2);
+
+/**
+ * @brief Checks if a node is in the subtree of another one (the node
+ * itself included), in O(1), by comparing the labels of their tags.
+ *
+ * @param node The node.
+ * @param ancestor The root of the subtree.
+ * @return 1 if node is in the subtree of ancestor, 0 otherwise.
+ */
+int g_node_in_subtree(const g_node_t *node, const g_node_t *ancestor);
+
+/**
+ * @brief Visits the nodes of a subtree in preorder by scanning the tags
+ * between the enter and the exit tag of its root, without going through
+ * the children arrays.
+ *
+ * @param root The root of the subtree.
+ * @param visit Called on every node of the subtree, with its depth below
+ * root.
+ * @param arg Passed to visit.
+ * @return 1 if visit stopped the scan, 0 otherwise.
+ */
+int g_subtree_scan(g_node_t *root, g_visit_fn visit, void *arg);
+
+/**
+ * @brief Finds the lowest common ancestor of two nodes of a tree with the
+ * cheaper engine. If a node is in the subtree of the other one, that node
+ * is the answer. Otherwise, binary lifting while the tree changes often,
+ * the Euler tour cache once the tree got enough queries since its last
+ * change to pay for the rebuild (see EULER_CACHE_NODES_PER_QUERY).
+ *
+ * @param g_tree The tree that holds both nodes.
+ * @param node_1 The first node.
+ * @param node_2 The second node.
+ * @return A pointer to the lowest common ancestor.
+ */
+g_node_t *tree_lca(g_tree_t *g_tree, g_node_t *node_1, g_node_t *node_2);
+
+/**
+ * @brief Counts the number of nodes in a subtree.
+ * If the node is NULL, the function returns 0, indicating that there are
+ * no nodes.
+ * Otherwise, walk the subtree with g_tree_walk() and count every visited
+ * node.
  *
  * @param g_node The root node of the subtree.
  * @return The number of nodes in the subtree.
@@ -161,7 +396,8 @@ int count_tree_nodes_recursive(g_node_t *g_node);
 int count_tree_nodes(g_tree_t *g_tree);
 
 /**
- * @brief Recursively deletes a subtree starting from the given node.
+ * @brief Deletes a subtree starting from the given node. The nodes are freed
+ * in postorder, with g_tree_walk(), so every node outlives its children.
  *
  * @param node The node to start deleting from.
  * @param free_value_function Function to free the data in each node.
@@ -171,6 +407,10 @@ void delete_subtree_recursively(g_node_t *node,
 
 /**
  * @brief Deletes a subtree starting from the node with the given parent_id.
+ * The range of tags of the subtree is cut out of the preorder list, then
+ * scanned to remove the deleted nodes from the id index (and to free them
+ * if the tree has no arena). The max likes of the ancestors that got theirs
+ * from the subtree are recomputed.
  *
  * @param g_tree The generic tree to delete from.
  * @param parent_id The ID of the parent node to start deleting from.
@@ -178,14 +418,18 @@ void delete_subtree_recursively(g_node_t *node,
 void delete_subtree(g_tree_t *g_tree, int parent_id);
 
 /**
- * @brief Frees the memory allocated for the generic tree.
+ * @brief Frees the memory allocated for the generic tree, including its
+ * Euler tour cache. A tree with an arena is freed by releasing the arena,
+ * without visiting its nodes. The tree structure itself is kept for the
+ * next tree, so that the index can tell that its entries are stale.
  *
  * @param g_tree The generic tree to be freed.
  */
 void free_g_tree(g_tree_t *g_tree);
 
 /**
- * @brief Recursively prints the tree starting from the given node.
+ * @brief Prints the tree starting from the given node, in preorder, with
+ * g_subtree_scan().
  *
  * @param node The node to start printing from.
  * @param level The current level in the tree.
@@ -4,60 +4,86 @@
 
 #include "graph.h"
 #include "users.h"
+#include "workspace.h"
 
-int min_path(list_graph_t *graph, int src, int dest)
-{
-	int *distance = calloc(graph->nodes, sizeof(int));
-	int *parent = calloc(graph->nodes, sizeof(int));
-	int *state = calloc(graph->nodes, sizeof(int));
-
-	for (int i = 0; i < graph->nodes; i++) {
-		distance[i] = INF;
-		parent[i] = -1;
-		state[i] = ALB;
-	}
+/*
+ * The snapshot is rebuilt once the patched rows hold more than
+ * 1 / CSR_REBUILD_RATIO of the nodes and edges, so the O(nodes + edges)
+ * rebuild is amortized over that many changes.
+ */
+#define CSR_REBUILD_RATIO 4
 
-	if (!graph)
-		return -1;
+static int is_node_in_graph(int n, int nodes)
+{
+	return n >= 0 && n < nodes;
+}
 
-	queue_t *q = q_create(sizeof(int), graph->nodes);
-
-	q_enqueue(q, &src);
-	state[src] = NEGRU;
-	distance[src] = 0;
-
-	while (!q_is_empty(q)) {
-		int current_node;
-		memcpy(&current_node, q_front(q), sizeof(int));
-		q_dequeue(q);
-
-		ll_node_t *neighbor = graph->neighbors[current_node]->head;
-		while (neighbor) {
-			int neighbour_data = *(int *)neighbor->data;
-			if (state[neighbour_data] == ALB) {
-				state[neighbour_data] = NEGRU;
-				parent[neighbour_data] = current_node;
-				distance[neighbour_data] = distance[current_node] + 1;
-				q_enqueue(q, &neighbour_data);
+/*
+ * Expands one whole BFS level of one side of the search. The workspace
+ * holds d + 1 for the nodes reached by this side and -(d + 1) for the nodes
+ * reached by the other side, where d is the distance from the side's origin.
+ * Returns the length of the path through the first meeting point, or -1.
+ */
+static int expand_level(list_graph_t *graph, query_workspace_t *ws, int sign,
+						int *order, int *level_start, int *level_end)
+{
+	int end = *level_end;
+
+	for (int i = *level_start; i < *level_end; i++) {
+		int current_node = order[i];
+		int current_dist = ws_get(ws, current_node) * sign;
+		int degree;
+		const int *neighbours = lg_neighbours(graph, current_node, &degree);
+
+		for (int j = 0; j < degree; j++) {
+			int neighbour = neighbours[j];
+			int visited = ws_get(ws, neighbour) * sign;
+
+			if (!visited) {
+				ws_set(ws, neighbour, (current_dist + 1) * sign);
+				order[end++] = neighbour;
+			} else if (visited < 0) {
+				/* Both distances are stored off by one */
+				return current_dist - visited - 1;
 			}
-			neighbor = neighbor->next;
 		}
 	}
 
-	if (parent[dest] == -1) {
-		free(distance);
-		free(parent);
-		free(state);
-		q_free(q);
-		return -1;
-	}
+	*level_start = *level_end;
+	*level_end = end;
 
-	int path_length = distance[dest];
+	return -1;
+}
 
-	free(distance);
-	free(parent);
-	free(state);
-	q_free(q);
+int min_path(list_graph_t *graph, int src, int dest)
+{
+	if (!graph || !is_node_in_graph(src, graph->nodes) ||
+		!is_node_in_graph(dest, graph->nodes) || src == dest)
+		return -1;
+
+	query_workspace_t *ws = ws_acquire(graph->nodes);
+	int *order_src = ws_buffer(ws, 0, graph->nodes);
+	int *order_dest = ws_buffer(ws, 1, graph->nodes);
+
+	int start_src = 0, end_src = 1;
+	int start_dest = 0, end_dest = 1;
+	int path_length = -1;
+
+	order_src[0] = src;
+	ws_set(ws, src, 1);
+	order_dest[0] = dest;
+	ws_set(ws, dest, -1);
+
+	/* Always grow the side with the smaller frontier */
+	while (path_length == -1 && start_src < end_src &&
+		   start_dest < end_dest) {
+		if (end_src - start_src <= end_dest - start_dest)
+			path_length = expand_level(graph, ws, 1, order_src,
+									   &start_src, &end_src);
+		else
+			path_length = expand_level(graph, ws, -1, order_dest,
+									   &start_dest, &end_dest);
+	}
 
 	return path_length;
 }
@@ -67,92 +93,237 @@ int compare_ints(void *a, void *b)
 	return *(int *)a - *(int *)b;
 }
 
-static int is_node_in_graph(int n, int nodes)
+static void csr_clear_stale(csr_graph_t *csr)
 {
-	return n >= 0 && n < nodes;
+	for (int i = 0; i < csr->n_stale; i++)
+		csr->stale[csr->stale_nodes[i]] = 0;
+
+	csr->n_stale = 0;
+	csr->stale_edges = 0;
+}
+
+static void csr_reserve(csr_graph_t *csr, int old_capacity, int capacity)
+{
+	csr->stale = realloc(csr->stale, capacity * sizeof(*csr->stale));
+	DIE(!csr->stale, "realloc csr stale failed");
+	csr->stale_nodes = realloc(csr->stale_nodes,
+							   capacity * sizeof(*csr->stale_nodes));
+	DIE(!csr->stale_nodes, "realloc csr stale failed");
+
+	memset(csr->stale + old_capacity, 0, capacity - old_capacity);
+}
+
+void lg_build_csr(list_graph_t *graph)
+{
+	csr_graph_t *csr = &graph->csr;
+	int edges = 0;
+
+	csr_clear_stale(csr);
+
+	for (int i = 0; i < graph->nodes; i++)
+		edges += graph->neighbors[i].size;
+
+	free(csr->offsets);
+	free(csr->targets);
+	csr->offsets = malloc((graph->nodes + 1) * sizeof(*csr->offsets));
+	DIE(!csr->offsets, "malloc csr offsets failed");
+	csr->targets = malloc((edges ? edges : 1) * sizeof(*csr->targets));
+	DIE(!csr->targets, "malloc csr targets failed");
+
+	edges = 0;
+	for (int i = 0; i < graph->nodes; i++) {
+		csr->offsets[i] = edges;
+		if (!graph->neighbors[i].size)
+			continue;
+		memcpy(csr->targets + edges, graph->neighbors[i].data,
+			   graph->neighbors[i].size * sizeof(int));
+		edges += graph->neighbors[i].size;
+	}
+	csr->offsets[graph->nodes] = edges;
+
+	csr->nodes = graph->nodes;
+	csr->edges = edges;
+}
+
+/*
+ * Marks the snapshot row of a node as stale, so it is read from the
+ * adjacency array of the node until the next rebuild.
+ */
+static void csr_mark_stale(list_graph_t *graph, int node)
+{
+	csr_graph_t *csr = &graph->csr;
+
+	if (!csr->stale[node]) {
+		csr->stale[node] = 1;
+		csr->stale_nodes[csr->n_stale++] = node;
+		csr->stale_edges += graph->neighbors[node].size;
+	}
+	csr->stale_edges++;
+
+	if (csr->stale_edges * CSR_REBUILD_RATIO >
+		(long)csr->edges + graph->nodes)
+		lg_build_csr(graph);
+}
+
+const int *lg_neighbours(list_graph_t *graph, int node, int *degree)
+{
+	*degree = 0;
+
+	if (!graph || !is_node_in_graph(node, graph->nodes))
+		return NULL;
+
+	csr_graph_t *csr = &graph->csr;
+
+	if (csr->stale[node]) {
+		*degree = graph->neighbors[node].size;
+		return graph->neighbors[node].data;
+	}
+
+	/* Nodes added after the last rebuild have no edges yet */
+	if (node >= csr->nodes)
+		return NULL;
+
+	*degree = csr->offsets[node + 1] - csr->offsets[node];
+	return csr->targets + csr->offsets[node];
 }
 
 list_graph_t *lg_create(int nodes)
 {
 	int i;
 
-	list_graph_t *g = malloc(sizeof(*g));
-	DIE(!g, "malloc graph failed");
+	list_graph_t *g = calloc(1, sizeof(*g));
+	DIE(!g, "calloc graph failed");
 
-	g->neighbors = malloc(nodes * sizeof(*g->neighbors));
+	g->neighbors = malloc((nodes ? nodes : 1) * sizeof(*g->neighbors));
 	DIE(!g->neighbors, "malloc neighbours failed");
 
 	for (i = 0; i != nodes; ++i)
-		g->neighbors[i] = ll_create(sizeof(int));
+		iv_init(&g->neighbors[i]);
 
 	g->nodes = nodes;
+	g->capacity = nodes ? nodes : 1;
+
+	csr_reserve(&g->csr, 0, g->capacity);
+	lg_build_csr(g);
 
 	return g;
 }
 
-void lg_add_edge(list_graph_t *graph, int src, int dest)
+void lg_grow(list_graph_t *graph, int nodes)
 {
-	if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
-		!is_node_in_graph(dest, graph->nodes))
+	if (!graph || nodes <= graph->nodes)
 		return;
 
-	ll_add_nth_node(graph->neighbors[src], graph->neighbors[src]->size, &dest);
+	if (nodes > graph->capacity) {
+		int capacity = graph->capacity;
+
+		while (capacity < nodes)
+			capacity *= 2;
+
+		graph->neighbors = realloc(graph->neighbors,
+								   capacity * sizeof(*graph->neighbors));
+		DIE(!graph->neighbors, "realloc neighbours failed");
+		csr_reserve(&graph->csr, graph->capacity, capacity);
+		graph->capacity = capacity;
+	}
+
+	for (int i = graph->nodes; i < nodes; ++i)
+		iv_init(&graph->neighbors[i]);
+
+	graph->nodes = nodes;
 }
 
-ll_node_t *find_node(linked_list_t *ll, int node, unsigned int *pos)
+#define BITS_PER_WORD (8 * sizeof(unsigned long))
+#define BITSET_WORDS (LG_BITSET_MAX_NODES / BITS_PER_WORD)
+
+/* Sets or clears the bit of dest in the neighbour bitset of src */
+static void update_neighbour_bit(list_graph_t *graph, int src, int dest,
+								 int set)
 {
-	ll_node_t *crt = ll->head;
-	unsigned int i;
+	/* The graph never shrinks, so the bitsets are not needed anymore */
+	if (graph->nodes > LG_BITSET_MAX_NODES)
+		return;
 
-	for (i = 0; i != ll->size; ++i)
-	{
-		if (node == *(int *)crt->data)
-		{
-			*pos = i;
-			return crt;
-		}
+	if (!graph->neighbour_bits) {
+		graph->neighbour_bits = calloc(LG_BITSET_MAX_NODES,
+									   sizeof(*graph->neighbour_bits));
+		DIE(!graph->neighbour_bits, "calloc neighbour bits failed");
+	}
+
+	unsigned long *bits = graph->neighbour_bits[src];
 
-		crt = crt->next;
+	if (!bits) {
+		if (!set)
+			return;
+		bits = calloc(BITSET_WORDS, sizeof(*bits));
+		DIE(!bits, "calloc neighbour bits failed");
+		graph->neighbour_bits[src] = bits;
 	}
 
-	return NULL;
+	if (set)
+		bits[dest / BITS_PER_WORD] |= 1UL << (dest % BITS_PER_WORD);
+	else
+		bits[dest / BITS_PER_WORD] &= ~(1UL << (dest % BITS_PER_WORD));
 }
 
-int lg_has_edge(list_graph_t *graph, int src, int dest)
+int lg_add_edge(list_graph_t *graph, int src, int dest)
 {
-	unsigned int pos;
+	if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
+		!is_node_in_graph(dest, graph->nodes))
+		return 0;
+
+	if (!iv_insert_sorted(&graph->neighbors[src], dest))
+		return 0;
 
+	csr_mark_stale(graph, src);
+	update_neighbour_bit(graph, src, dest, 1);
+	return 1;
+}
+
+int lg_has_edge(list_graph_t *graph, int src, int dest)
+{
 	if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
 		!is_node_in_graph(dest, graph->nodes))
 		return 0;
 
-	if (find_node(graph->neighbors[src], dest, &pos))
-		return 1;
-	return 0;
+	return iv_contains_sorted(&graph->neighbors[src], dest);
 }
 
-linked_list_t *lg_get_neighbours(list_graph_t *graph, int node)
+const int_vector_t *lg_get_neighbours(list_graph_t *graph, int node)
 {
 	if (!graph || !graph->neighbors || !is_node_in_graph(node, graph->nodes))
 		return NULL;
 
-	return graph->neighbors[node];
+	return &graph->neighbors[node];
 }
 
 void lg_remove_edge(list_graph_t *graph, int src, int dest)
 {
-	unsigned int pos;
-
 	if (!graph || !graph->neighbors || !is_node_in_graph(src, graph->nodes) ||
 		!is_node_in_graph(dest, graph->nodes))
 		return;
 
-	if (!find_node(graph->neighbors[src], dest, &pos))
-		return;
+	if (iv_remove_sorted(&graph->neighbors[src], dest)) {
+		csr_mark_stale(graph, src);
+		update_neighbour_bit(graph, src, dest, 0);
+	}
+}
+
+int lg_neighbour_bits(list_graph_t *graph, int node,
+					  const unsigned long **bits, unsigned int *n_words)
+{
+	*bits = NULL;
+	*n_words = 0;
+	if (!graph || !is_node_in_graph(node, graph->nodes) ||
+		graph->nodes > LG_BITSET_MAX_NODES)
+		return 0;
 
-	ll_node_t *removed_node = ll_remove_nth_node(graph->neighbors[src], pos);
-	free(removed_node->data);
-	free(removed_node);
+	/* Every node is below LG_BITSET_MAX_NODES, so every edge has its bit */
+	if (graph->neighbour_bits && graph->neighbour_bits[node]) {
+		*bits = graph->neighbour_bits[node];
+		*n_words = (graph->nodes + BITS_PER_WORD - 1) / BITS_PER_WORD;
+	}
+	return 1;
 }
 
 void lg_free(list_graph_t *graph)
@@ -160,7 +331,18 @@ void lg_free(list_graph_t *graph)
 	int i;
 
 	for (i = 0; i != graph->nodes; ++i)
-		ll_free(graph->neighbors + i);
+		iv_free(graph->neighbors + i);
+
+	free(graph->csr.offsets);
+	free(graph->csr.targets);
+	free(graph->csr.stale);
+	free(graph->csr.stale_nodes);
+
+	if (graph->neighbour_bits) {
+		for (i = 0; i != LG_BITSET_MAX_NODES; ++i)
+			free(graph->neighbour_bits[i]);
+		free(graph->neighbour_bits);
+	}
 
 	free(graph->neighbors);
 	free(graph);
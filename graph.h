@@ -7,23 +7,56 @@
 #include <string.h>
 #include <errno.h>
 
-#include "queue.h"
-#include "linked_list.h"
+#include "int_vector.h"
 
 typedef enum {ALB, NEGRU} color;
 #define INF 9999999
-#define MAX_QUEUE_SIZE 100
+/*
+ * The nodes also keep a bitset of their neighbours while the graph has at
+ * most this many nodes; the bitset of a node takes LG_BITSET_MAX_NODES / 8
+ * bytes.
+ */
+#define LG_BITSET_MAX_NODES 4096
 
+typedef struct csr_graph_t csr_graph_t;
 typedef struct list_graph_t list_graph_t;
 
+/**
+ * @struct csr_graph_t
+ * @brief Read-optimized (compressed sparse row) snapshot of a graph.
+ * The neighbours of node i are targets[offsets[i]] .. targets[offsets[i + 1]
+ * - 1]. Rows changed after the snapshot was built are marked as stale and
+ * are read straight from the adjacency array of that node instead.
+ * When the stale rows grow past a fraction of the graph, the whole snapshot
+ * is rebuilt.
+ */
+struct csr_graph_t
+{
+	int *offsets; /* Start of every row in targets (nodes + 1 entries). */
+	int *targets; /* The neighbours of every node, row after row. */
+	int nodes; /* Number of nodes covered by offsets. */
+	int edges; /* Number of entries in targets. */
+	unsigned char *stale; /* 1 for the rows changed since the rebuild. */
+	int *stale_nodes; /* Nodes that currently have a stale row. */
+	int n_stale; /* Number of entries in stale_nodes. */
+	long stale_edges; /* Changes done to the stale rows since the rebuild. */
+};
+
 /**
  * @struct list_graph_t
  * @brief Represents a graph using an adjacency list.
+ * Every adjacency list is a sorted array without duplicates. The adjacency
+ * lists are the source of truth and are the only thing changed by the
+ * mutations. Read queries go through the CSR snapshot (see lg_neighbours()).
  */
 struct list_graph_t
 {
-	linked_list_t **neighbors; /* Array of linked lists. */
+	int_vector_t *neighbors; /* Sorted adjacency array of every node. */
 	int nodes; /* Number of nodes in the graph. */
+	int capacity; /* Number of allocated entries in neighbors. */
+	csr_graph_t csr; /* Read-optimized snapshot of neighbors. */
+	/* Bitset of the neighbours of every node, NULL for the ones without. */
+	unsigned long **neighbour_bits;
 };
 
 /**
@@ -36,17 +69,17 @@ struct list_graph_t
 int compare_ints(void *a, void *b);
 
 /**
- * Finds the minimum path between two nodes in a graph using BFS.
- * Create and initialize arrays to keep track of distances, parents,
- * and states of nodes.
- * Return -1 if the graph is null.
- * Initialize BFS: Create a queue, enqueue the source node, and set its
- * state and distance.
- * BFS Loop: Process nodes in the queue, updating distances and states for
- * each neighboring node.
- * If the destination node has no parent, there is no path.
- *  Return the calculated path length.
- * Cleanup: Free allocated memory and return the result.
+ * Finds the minimum path between two nodes in a graph using a bidirectional
+ * BFS. The graph must be undirected (every friendship is stored in both
+ * directions), so the search from dest can use the same adjacency lists.
+ * Return -1 if the graph is null, a node is invalid or src == dest.
+ * Initialize one BFS from src and one from dest, sharing a visited array
+ * where each side stores its distances with its own sign.
+ * BFS Loop: Expand one whole level of the side with the smaller frontier.
+ * As soon as an edge reaches a node visited by the other side, the two
+ * searches have met and the path through that edge is a shortest one.
+ * If one of the frontiers becomes empty, there is no path.
+ * Return the path length.
  * @param graph - The graph in which to find the path.
  * @param src - The source node.
  * @param dest - The destination node.
@@ -63,26 +96,28 @@ int min_path(list_graph_t *graph, int src, int dest);
 list_graph_t *lg_create(int nodes);
 
 /**
- * Adds an edge to the graph.
+ * Adds nodes to the graph, so that it has the given number of nodes.
+ * The new nodes have no edges. Nothing happens if the graph is already
+ * big enough.
  *
  * @param graph - The graph.
- * @param src - The source node.
- * @param dest - The destination node.
+ * @param nodes - The new number of nodes.
  */
-void lg_add_edge(list_graph_t *graph, int src, int dest);
+void lg_grow(list_graph_t *graph, int nodes);
 
 /**
- * Finds a node in the linked list.
+ * Adds an edge to the graph. The adjacency array of src stays sorted and
+ * an edge that already exists is not added again.
  *
- * @param ll - The linked list.
- * @param node - The node data to find.
- * @param pos - Pointer to store the position of the node.
- * @return A pointer to the found node, or NULL if not found.
+ * @param graph - The graph.
+ * @param src - The source node.
+ * @param dest - The destination node.
+ * @return 1 if the edge was added, 0 if it already existed or is invalid.
  */
-ll_node_t *find_node(linked_list_t *ll, int node, unsigned int *pos);
+int lg_add_edge(list_graph_t *graph, int src, int dest);
 
 /**
- * Checks if an edge exists in the graph.
+ * Checks if an edge exists in the graph, using binary search.
  *
  * @param graph - The graph.
  * @param src - The source node.
@@ -96,13 +131,51 @@ int lg_has_edge(list_graph_t *graph, int src, int dest);
  *
  * @param graph - The graph.
  * @param node - The node whose neighbors to get.
- * @return A pointer to the linked list of neighbors
+ * @return A pointer to the sorted adjacency array of the node
  * or NULL if node is invalid.
  */
-linked_list_t *lg_get_neighbours(list_graph_t *graph, int node);
+const int_vector_t *lg_get_neighbours(list_graph_t *graph, int node);
+
+/**
+ * Gets the neighbours of a node from the CSR snapshot of the graph.
+ * The returned array stays valid until the next change of the graph.
+ *
+ * @param graph - The graph.
+ * @param node - The node whose neighbors to get.
+ * @param degree - Where to store the number of neighbours.
+ * @return A pointer to the neighbours of the node, sorted by id, or NULL
+ * (and a degree of 0) if node is invalid or has no neighbours.
+ */
+const int *lg_neighbours(list_graph_t *graph, int node, int *degree);
+
+/**
+ * Gets the bitset of the neighbours of a node: bit i of the word
+ * i / (8 * sizeof(unsigned long)) is set if i is a neighbour. The bitsets
+ * are only kept while the graph has at most LG_BITSET_MAX_NODES nodes.
+ * The returned array stays valid until the next change of the graph.
+ *
+ * @param graph - The graph.
+ * @param node - The node whose neighbours to get.
+ * @param bits - Where to store the bitset, NULL if the node has no
+ * neighbours.
+ * @param n_words - Where to store the number of words of the bitset.
+ * @return 1 if the bitset is kept, 0 if the graph is too large or node is
+ * invalid.
+ */
+int lg_neighbour_bits(list_graph_t *graph, int node,
+					  const unsigned long **bits, unsigned int *n_words);
+
+/**
+ * Rebuilds the CSR snapshot of the graph from the adjacency lists and
+ * clears the stale rows. It is called automatically when the stale rows
+ * become too large.
+ *
+ * @param graph - The graph.
+ */
+void lg_build_csr(list_graph_t *graph);
 
 /**
- * Removes an edge from the graph.
+ * Removes an edge from the graph, using binary search.
  *
  * @param graph - The graph.
  * @param src - The source node.
@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "int_vector.h"
+
+void iv_init(int_vector_t *v)
+{
+	v->data = NULL;
+	v->size = 0;
+	v->capacity = 0;
+}
+
+void iv_reserve(int_vector_t *v, unsigned int capacity)
+{
+	if (capacity <= v->capacity)
+		return;
+
+	unsigned int new_capacity = v->capacity ? v->capacity : 4;
+
+	while (new_capacity < capacity)
+		new_capacity *= 2;
+
+	v->data = realloc(v->data, new_capacity * sizeof(*v->data));
+	DIE(!v->data, "realloc vector failed");
+	v->capacity = new_capacity;
+}
+
+void iv_push_back(int_vector_t *v, int value)
+{
+	if (v->size == v->capacity)
+		iv_reserve(v, v->size + 1);
+
+	v->data[v->size++] = value;
+}
+
+unsigned int iv_lower_bound(const int *data, unsigned int size, int value)
+{
+	unsigned int left = 0, right = size;
+
+	while (left < right) {
+		unsigned int mid = left + (right - left) / 2;
+
+		if (data[mid] < value)
+			left = mid + 1;
+		else
+			right = mid;
+	}
+
+	return left;
+}
+
+unsigned int iv_gallop(const int *data, unsigned int size, unsigned int from,
+					   int value)
+{
+	unsigned int step = 1;
+
+	if (from >= size || data[from] >= value)
+		return from;
+
+	/* data[from] < value, find a bound with data[from + step] >= value */
+	while (from + step < size && data[from + step] < value) {
+		from += step;
+		step *= 2;
+	}
+
+	unsigned int end = from + step < size ? from + step + 1 : size;
+
+	return from + 1 + iv_lower_bound(data + from + 1, end - from - 1, value);
+}
+
+int iv_contains_sorted(const int_vector_t *v, int value)
+{
+	unsigned int pos = iv_lower_bound(v->data, v->size, value);
+
+	return pos < v->size && v->data[pos] == value;
+}
+
+int iv_insert_sorted(int_vector_t *v, int value)
+{
+	unsigned int pos = iv_lower_bound(v->data, v->size, value);
+
+	if (pos < v->size && v->data[pos] == value)
+		return 0;
+
+	if (v->size == v->capacity)
+		iv_reserve(v, v->size + 1);
+
+	memmove(v->data + pos + 1, v->data + pos,
+			(v->size - pos) * sizeof(*v->data));
+	v->data[pos] = value;
+	v->size++;
+
+	return 1;
+}
+
+int iv_remove_sorted(int_vector_t *v, int value)
+{
+	unsigned int pos = iv_lower_bound(v->data, v->size, value);
+
+	if (pos == v->size || v->data[pos] != value)
+		return 0;
+
+	memmove(v->data + pos, v->data + pos + 1,
+			(v->size - pos - 1) * sizeof(*v->data));
+	v->size--;
+
+	return 1;
+}
+
+void iv_free(int_vector_t *v)
+{
+	free(v->data);
+	iv_init(v);
+}
@@ -0,0 +1,111 @@
+#ifndef INT_VECTOR_H
+#define INT_VECTOR_H
+
+#define DIE(condition, message) \
+	do { \
+		if (condition) { \
+			fprintf(stderr, "%s\n", message); \
+			exit(EXIT_FAILURE); \
+		} \
+	} while (0)
+
+typedef struct int_vector_t int_vector_t;
+
+/**
+ * @struct int_vector_t
+ * @brief Represents a growable array of integers.
+ * The iv_*_sorted functions keep the array sorted in ascending order and
+ * without duplicates.
+ */
+struct int_vector_t
+{
+	int *data; /* The elements. */
+	unsigned int size; /* Number of elements in the vector. */
+	unsigned int capacity; /* Number of allocated elements. */
+};
+
+/**
+ * Initializes an empty vector.
+ *
+ * @param v - The vector.
+ */
+void iv_init(int_vector_t *v);
+
+/**
+ * Makes sure the vector can hold at least capacity elements.
+ *
+ * @param v - The vector.
+ * @param capacity - The number of elements.
+ */
+void iv_reserve(int_vector_t *v, unsigned int capacity);
+
+/**
+ * Appends an element at the end of the vector.
+ *
+ * @param v - The vector.
+ * @param value - The element to append.
+ */
+void iv_push_back(int_vector_t *v, int value);
+
+/**
+ * Finds the first element of a sorted array that is not less than value,
+ * using binary search.
+ *
+ * @param data - The sorted array.
+ * @param size - The number of elements in the array.
+ * @param value - The value to search for.
+ * @return The position of that element, or size if there is none.
+ */
+unsigned int iv_lower_bound(const int *data, unsigned int size, int value);
+
+/**
+ * Same as iv_lower_bound(), but only looks at data[from..size) and probes
+ * positions from + 1, from + 2, from + 4, ... before the binary search
+ * (galloping search). It is cheap when the answer is close to from, which
+ * is the case when two sorted arrays of very different sizes are merged.
+ *
+ * @param data - The sorted array.
+ * @param size - The number of elements in the array.
+ * @param from - The position to start from.
+ * @param value - The value to search for.
+ * @return The position of the first element not less than value,
+ * or size if there is none.
+ */
+unsigned int iv_gallop(const int *data, unsigned int size, unsigned int from,
+					   int value);
+
+/**
+ * Checks if a sorted vector contains a value.
+ *
+ * @param v - The sorted vector.
+ * @param value - The value to search for.
+ * @return 1 if the value is in the vector, 0 otherwise.
+ */
+int iv_contains_sorted(const int_vector_t *v, int value);
+
+/**
+ * Inserts a value in a sorted vector, if it is not already there.
+ *
+ * @param v - The sorted vector.
+ * @param value - The value to insert.
+ * @return 1 if the value was inserted, 0 if it was already in the vector.
+ */
+int iv_insert_sorted(int_vector_t *v, int value);
+
+/**
+ * Removes a value from a sorted vector.
+ *
+ * @param v - The sorted vector.
+ * @param value - The value to remove.
+ * @return 1 if the value was removed, 0 if it was not in the vector.
+ */
+int iv_remove_sorted(int_vector_t *v, int value);
+
+/**
+ * Frees the elements of the vector and leaves it empty.
+ *
+ * @param v - The vector.
+ */
+void iv_free(int_vector_t *v);
+
+#endif /* INT_VECTOR_H */
@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "like_set.h"
+
+#define BITS_PER_WORD (8 * sizeof(unsigned long))
+
+void ls_init(like_set_t *set, arena_t *arena)
+{
+	memset(set, 0, sizeof(*set));
+	set->arena = arena;
+}
+
+static void *set_alloc(like_set_t *set, size_t size)
+{
+	if (set->arena)
+		return arena_alloc(set->arena, size);
+
+	void *memory = calloc(1, size);
+
+	DIE(!memory, "calloc like set failed");
+	return memory;
+}
+
+static void set_release(like_set_t *set, void *memory)
+{
+	if (!set->arena)
+		free(memory);
+}
+
+static unsigned int hash_id(int id, unsigned int capacity)
+{
+	/* Fibonacci hashing; capacity is a power of two */
+	return ((unsigned int)id * 2654435761u) & (capacity - 1);
+}
+
+/* Returns the slot of id, or the empty slot where it would go */
+static unsigned int find_slot(const like_set_t *set, int id)
+{
+	unsigned int slot = hash_id(id, set->capacity);
+
+	while (set->slots[slot] != -1 && set->slots[slot] != id)
+		slot = (slot + 1) & (set->capacity - 1);
+
+	return slot;
+}
+
+static void hash_resize(like_set_t *set, unsigned int capacity)
+{
+	int *old_slots = set->slots;
+	unsigned int old_capacity = set->capacity;
+
+	set->slots = set_alloc(set, capacity * sizeof(*set->slots));
+	memset(set->slots, -1, capacity * sizeof(*set->slots));
+	set->capacity = capacity;
+
+	for (unsigned int i = 0; i < old_capacity; i++) {
+		if (old_slots[i] != -1)
+			set->slots[find_slot(set, old_slots[i])] = old_slots[i];
+	}
+	set_release(set, old_slots);
+}
+
+/* Moves the ids of a bitmap into a new hash table */
+static void bitmap_to_hash(like_set_t *set)
+{
+	unsigned long *bitmap = set->bitmap;
+	unsigned int words = set->capacity;
+	unsigned int capacity = LS_MIN_SLOTS;
+
+	while (capacity < 4 * (set->size + 1))
+		capacity *= 2;
+
+	set->is_hash = 1;
+	set->bitmap = NULL;
+	set->capacity = 0;
+	set->slots = NULL;
+	hash_resize(set, capacity);
+
+	for (unsigned int w = 0; w < words; w++) {
+		for (unsigned long bits = bitmap[w]; bits; bits &= bits - 1) {
+			int id = w * BITS_PER_WORD + __builtin_ctzl(bits);
+
+			set->slots[find_slot(set, id)] = id;
+		}
+	}
+	set_release(set, bitmap);
+}
+
+static void bitmap_reserve(like_set_t *set, int id)
+{
+	unsigned int words = id / BITS_PER_WORD + 1;
+
+	if (words <= set->capacity)
+		return;
+
+	/* Grow geometrically, up to the words needed for LS_BITMAP_MAX_ID */
+	unsigned int capacity = set->capacity ? 2 * set->capacity : 1;
+	unsigned int max_words = (LS_BITMAP_MAX_ID + BITS_PER_WORD - 1) /
+							 BITS_PER_WORD;
+
+	while (capacity < words)
+		capacity *= 2;
+	if (capacity > max_words)
+		capacity = max_words;
+
+	unsigned long *bitmap = set_alloc(set, capacity * sizeof(*bitmap));
+
+	if (set->capacity)
+		memcpy(bitmap, set->bitmap, set->capacity * sizeof(*bitmap));
+	set_release(set, set->bitmap);
+	set->bitmap = bitmap;
+	set->capacity = capacity;
+}
+
+int ls_contains(const like_set_t *set, int id)
+{
+	if (id < 0 || !set->capacity)
+		return 0;
+
+	if (!set->is_hash) {
+		if ((unsigned int)id / BITS_PER_WORD >= set->capacity)
+			return 0;
+		return (set->bitmap[id / BITS_PER_WORD] >> (id % BITS_PER_WORD)) & 1;
+	}
+
+	return set->slots[find_slot(set, id)] == id;
+}
+
+/* Removes the id in slot, shifting back the ids probed past it */
+static void hash_remove(like_set_t *set, unsigned int slot)
+{
+	unsigned int mask = set->capacity - 1;
+	unsigned int next = (slot + 1) & mask;
+
+	while (set->slots[next] != -1) {
+		unsigned int home = hash_id(set->slots[next], set->capacity);
+
+		/* The id in next may fill the hole if its home is not after it */
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			set->slots[slot] = set->slots[next];
+			slot = next;
+		}
+		next = (next + 1) & mask;
+	}
+	set->slots[slot] = -1;
+}
+
+int ls_toggle(like_set_t *set, int id)
+{
+	if (id < 0)
+		return -1;
+
+	if (!set->is_hash && id >= LS_BITMAP_MAX_ID)
+		bitmap_to_hash(set);
+
+	if (!set->is_hash) {
+		bitmap_reserve(set, id);
+
+		unsigned long bit = 1UL << (id % BITS_PER_WORD);
+		unsigned long *word = &set->bitmap[id / BITS_PER_WORD];
+
+		*word ^= bit;
+		if (*word & bit) {
+			set->size++;
+			return 1;
+		}
+		set->size--;
+		return 0;
+	}
+
+	unsigned int slot = find_slot(set, id);
+
+	if (set->slots[slot] == id) {
+		hash_remove(set, slot);
+		set->size--;
+		return 0;
+	}
+
+	set->slots[slot] = id;
+	set->size++;
+	if (2 * set->size > set->capacity)
+		hash_resize(set, 2 * set->capacity);
+
+	return 1;
+}
+
+int ls_bitmap(const like_set_t *set, const unsigned long **bitmap,
+			  unsigned int *n_words)
+{
+	*bitmap = set->is_hash ? NULL : set->bitmap;
+	*n_words = set->is_hash ? 0 : set->capacity;
+	return !set->is_hash;
+}
+
+unsigned int ls_size(const like_set_t *set)
+{
+	return set->size;
+}
+
+void ls_free(like_set_t *set)
+{
+	if (!set->arena) {
+		free(set->bitmap);
+		free(set->slots);
+	}
+	ls_init(set, set->arena);
+}
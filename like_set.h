@@ -0,0 +1,94 @@
+#ifndef LIKE_SET_H
+#define LIKE_SET_H
+
+#include "arena.h"
+
+/*
+ * A set stays a bitmap while every id in it is below this; the bitmap of a
+ * set then takes at most LS_BITMAP_MAX_ID / 8 bytes.
+ */
+#define LS_BITMAP_MAX_ID 4096
+/* Number of slots of a hash set when it is created */
+#define LS_MIN_SLOTS 16
+
+typedef struct like_set_t like_set_t;
+
+/**
+ * @struct like_set_t
+ * @brief Set of user ids, used for the likes of a post or repost.
+ * While the ids are small (a small population of users) the set is a
+ * bitmap with one bit per id. The first id of LS_BITMAP_MAX_ID or more
+ * turns it into a hash set with linear probing, kept at most half full.
+ * Removals shift the following entries back instead of leaving tombstones,
+ * so the table only grows with the number of likes, never with the number
+ * of toggles. Adding, removing and checking an id are O(1).
+ */
+struct like_set_t
+{
+	unsigned int size; /* Number of ids in the set. */
+	unsigned int capacity; /* Words of the bitmap or slots of the table. */
+	int is_hash; /* 1 if the set is a hash set, 0 if it is a bitmap. */
+	unsigned long *bitmap; /* Bit i is set if id i is in the set. */
+	int *slots; /* Hash table of ids, -1 marks an empty slot. */
+	arena_t *arena; /* Arena of the arrays, NULL to use malloc. */
+};
+
+/**
+ * Initializes an empty set. No memory is allocated until the first id is
+ * added.
+ *
+ * @param set - The set.
+ * @param arena - The arena to allocate the set from, or NULL for malloc.
+ * With an arena, the arrays outgrown by the set stay in the arena until it
+ * is released.
+ */
+void ls_init(like_set_t *set, arena_t *arena);
+
+/**
+ * Checks if an id is in the set.
+ *
+ * @param set - The set.
+ * @param id - The id.
+ * @return 1 if the id is in the set, 0 otherwise.
+ */
+int ls_contains(const like_set_t *set, int id);
+
+/**
+ * Adds an id to the set if it is not there, removes it otherwise.
+ *
+ * @param set - The set.
+ * @param id - The id, not negative.
+ * @return 1 if the id was added, 0 if it was removed, -1 if it is negative.
+ */
+int ls_toggle(like_set_t *set, int id);
+
+/**
+ * Gets the words of a set that is a bitmap: bit i of the word
+ * i / (8 * sizeof(unsigned long)) is set if i is in the set. The ids past
+ * the last word are not in the set.
+ *
+ * @param set - The set.
+ * @param bitmap - Where to store the words, NULL if there are none.
+ * @param n_words - Where to store the number of words.
+ * @return 1 if the set is a bitmap, 0 if it is a hash set.
+ */
+int ls_bitmap(const like_set_t *set, const unsigned long **bitmap,
+			  unsigned int *n_words);
+
+/**
+ * Gets the number of ids in the set.
+ *
+ * @param set - The set.
+ * @return The number of ids.
+ */
+unsigned int ls_size(const like_set_t *set);
+
+/**
+ * Frees the memory of a set that does not use an arena. The set is empty
+ * afterwards.
+ *
+ * @param set - The set.
+ */
+void ls_free(like_set_t *set);
+
+#endif /* LIKE_SET_H */
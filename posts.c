@@ -5,15 +5,311 @@
 #include "users.h"
 #include "posts.h"
 
+tree_post_manager *create_post_manager(void)
+{
+	tree_post_manager *post_manager = calloc(1, sizeof(*post_manager));
+
+	DIE(!post_manager, "calloc failed");
+	post_manager->id_counter = 1;
+
+	return post_manager;
+}
+
+void free_post_manager(tree_post_manager *post_manager)
+{
+	for (int i = 0; i < post_manager->n_posts; i++) {
+		if (post_manager->posts[i])
+			free_g_tree(post_manager->posts[i]);
+	}
+	for (int i = 0; i < post_manager->n_users; i++) {
+		iv_free(&post_manager->author_posts[i]);
+		free(post_manager->user_reposts[i].data);
+	}
+	free(post_manager->author_posts);
+	free(post_manager->user_reposts);
+	free(post_manager->posts);
+	free(post_manager->reposters);
+	free(post_manager->post_slots);
+	free(post_manager);
+}
+
+/* Records the slot of a post ID, growing the map to cover the ID */
+static void set_post_slot(tree_post_manager *post_manager, int id, int slot)
+{
+	if (id >= post_manager->n_post_slots) {
+		int n_slots = post_manager->n_post_slots ?
+					  post_manager->n_post_slots : MIN_POST_SLOTS;
+
+		while (n_slots <= id)
+			n_slots *= 2;
+
+		int *slots = realloc(post_manager->post_slots,
+							 n_slots * sizeof(*slots));
+
+		DIE(!slots, "realloc failed");
+		memset(slots + post_manager->n_post_slots, -1,
+			   (n_slots - post_manager->n_post_slots) * sizeof(*slots));
+		post_manager->post_slots = slots;
+		post_manager->n_post_slots = n_slots;
+	}
+
+	post_manager->post_slots[id] = slot;
+}
+
+/* Grows the lists of posts and reposts of the users to cover user_id */
+static void grow_user_lists(tree_post_manager *post_manager, int user_id)
+{
+	if (user_id < post_manager->n_users)
+		return;
+
+	int n_users = post_manager->n_users ?
+				  post_manager->n_users : MIN_POST_SLOTS;
+
+	while (n_users <= user_id)
+		n_users *= 2;
+
+	int_vector_t *posts = realloc(post_manager->author_posts,
+								  n_users * sizeof(*posts));
+
+	DIE(!posts, "realloc failed");
+	post_manager->author_posts = posts;
+
+	repost_list_t *reposts = realloc(post_manager->user_reposts,
+									 n_users * sizeof(*reposts));
+
+	DIE(!reposts, "realloc failed");
+	post_manager->user_reposts = reposts;
+
+	for (int i = post_manager->n_users; i < n_users; i++) {
+		iv_init(&posts[i]);
+		reposts[i] = (repost_list_t){NULL, 0, 0, 1};
+	}
+	post_manager->n_users = n_users;
+}
+
+/* Gets the list of posts of a user, growing the lists to cover the user */
+static int_vector_t *author_posts(tree_post_manager *post_manager, int user_id)
+{
+	grow_user_lists(post_manager, user_id);
+	return &post_manager->author_posts[user_id];
+}
+
+static int compare_reposts(const void *a, const void *b)
+{
+	const repost_entry_t *x = a, *y = b;
+
+	if (x->post_id != y->post_id)
+		return x->post_id < y->post_id ? -1 : 1;
+	return (x->repost_id > y->repost_id) - (x->repost_id < y->repost_id);
+}
+
+/* Sorts the reposts that were appended out of order */
+static void sort_reposts(repost_list_t *list)
+{
+	if (!list->sorted)
+		qsort(list->data, list->size, sizeof(*list->data), compare_reposts);
+	list->sorted = 1;
+}
+
+/* Position of the first repost of a list that is not before the given one */
+static unsigned int repost_lower_bound(const repost_list_t *list,
+									   int post_id, int repost_id)
+{
+	unsigned int low = 0, high = list->size;
+
+	while (low < high) {
+		unsigned int mid = low + (high - low) / 2;
+		const repost_entry_t *entry = &list->data[mid];
+
+		if (entry->post_id < post_id ||
+			(entry->post_id == post_id && entry->repost_id < repost_id))
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low;
+}
+
+/* Adds a repost to the list of its user and the user to the reposters */
+static void index_repost(tree_post_manager *post_manager, int user_id,
+						 int post_id, int repost_id)
+{
+	grow_user_lists(post_manager, user_id);
+
+	repost_list_t *list = &post_manager->user_reposts[user_id];
+
+	if (list->size == list->capacity) {
+		unsigned int capacity = list->capacity ? 2 * list->capacity : 4;
+		repost_entry_t *data = realloc(list->data,
+									   capacity * sizeof(*data));
+
+		DIE(!data, "realloc failed");
+		list->data = data;
+		list->capacity = capacity;
+	}
+
+	/*
+	 * A new repost has the largest ID, so the list stays sorted unless it
+	 * is a repost of an older post than the last one; it is sorted once,
+	 * when it is next read.
+	 */
+	if (list->size > 0 && list->data[list->size - 1].post_id > post_id)
+		list->sorted = 0;
+	list->data[list->size++] = (repost_entry_t){post_id, repost_id};
+
+	like_set_t *reposters =
+	&post_manager->reposters[post_manager->post_slots[post_id]];
+
+	if (!ls_contains(reposters, user_id))
+		ls_toggle(reposters, user_id);
+}
+
+/*
+ * Removes the given reposts of a post (sorted by ID) from the list of a
+ * user in one pass, and the user from the reposters if none of their
+ * reposts of the post is left
+ */
+static void unindex_reposts(tree_post_manager *post_manager, int user_id,
+							int post_id, const int *repost_ids, int n)
+{
+	repost_list_t *list = &post_manager->user_reposts[user_id];
+
+	sort_reposts(list);
+
+	/* The reposts of the post are next to each other */
+	unsigned int low = repost_lower_bound(list, post_id, 0);
+	unsigned int high = repost_lower_bound(list, post_id + 1, 0);
+	unsigned int size = low;
+	int k = 0;
+
+	for (unsigned int i = low; i < high; i++) {
+		while (k < n && repost_ids[k] < list->data[i].repost_id)
+			k++;
+		if (k == n || repost_ids[k] != list->data[i].repost_id)
+			list->data[size++] = list->data[i];
+	}
+
+	memmove(list->data + size, list->data + high,
+			(list->size - high) * sizeof(*list->data));
+	list->size -= high - size;
+
+	like_set_t *reposters =
+	&post_manager->reposters[post_manager->post_slots[post_id]];
+
+	if (size == low && ls_contains(reposters, user_id))
+		ls_toggle(reposters, user_id);
+}
+
+const like_set_t *get_reposters(const tree_post_manager *post_manager,
+								int post_id)
+{
+	if (post_id < 0 || post_id >= post_manager->n_post_slots)
+		return NULL;
+
+	int slot = post_manager->post_slots[post_id];
+
+	return slot < 0 ? NULL : &post_manager->reposters[slot];
+}
+
+const repost_entry_t *get_user_reposts(tree_post_manager *post_manager,
+									   int user_id, int *n_reposts)
+{
+	if (user_id < 0 || user_id >= post_manager->n_users) {
+		*n_reposts = 0;
+		return NULL;
+	}
+
+	repost_list_t *list = &post_manager->user_reposts[user_id];
+	unsigned int size = 0;
+	int last_post_id = -1, live = 0;
+
+	sort_reposts(list);
+
+	/* Drop the reposts of the deleted posts, keeping the order */
+	for (unsigned int i = 0; i < list->size; i++) {
+		if (list->data[i].post_id != last_post_id) {
+			last_post_id = list->data[i].post_id;
+			live = !!search_g_tree(post_manager, last_post_id);
+		}
+		if (live)
+			list->data[size++] = list->data[i];
+	}
+	list->size = size;
+
+	*n_reposts = size;
+	return list->data;
+}
+
+const int *get_author_posts(const tree_post_manager *post_manager,
+							int user_id, int *n_posts)
+{
+	if (user_id < 0 || user_id >= post_manager->n_users) {
+		*n_posts = 0;
+		return NULL;
+	}
+
+	const int_vector_t *posts = &post_manager->author_posts[user_id];
+
+	*n_posts = posts->size;
+	return posts->data;
+}
+
+/* Moves the live posts over the tombstones, keeping their order */
+static void compact_posts(tree_post_manager *post_manager)
+{
+	int n_posts = 0;
+
+	for (int i = 0; i < post_manager->n_posts; i++) {
+		g_tree_t *post_tree = post_manager->posts[i];
+
+		if (!post_tree)
+			continue;
+		post_manager->posts[n_posts] = post_tree;
+		post_manager->reposters[n_posts] = post_manager->reposters[i];
+		set_post_slot(post_manager, ((info *)post_tree->root->data)->id,
+					  n_posts);
+		n_posts++;
+	}
+
+	post_manager->n_posts = n_posts;
+	post_manager->n_deleted = 0;
+}
+
 void create_post(tree_post_manager *post_manager, char *name, char *title)
 {
-	post_manager->posts[post_manager->n_posts] =
-	init_generic_tree(sizeof(info), free_value_post, MAX_CHILDREN);
-	info *g_node_data  = create_info(post_manager->id_counter,
-									 get_user_id(name), title);
-	insert_node(post_manager->posts[post_manager->n_posts],
-				g_node_data, 0);
+	g_tree_t *post_tree = init_generic_tree_in_arena(sizeof(info), 0);
+
+	if (post_manager->n_posts == post_manager->capacity) {
+		int capacity = post_manager->capacity ?
+					   2 * post_manager->capacity : MIN_POST_SLOTS;
+		g_tree_t **posts = realloc(post_manager->posts,
+								   capacity * sizeof(*posts));
+
+		DIE(!posts, "realloc failed");
+		post_manager->posts = posts;
+
+		like_set_t *reposters = realloc(post_manager->reposters,
+										capacity * sizeof(*reposters));
+
+		DIE(!reposters, "realloc failed");
+		post_manager->reposters = reposters;
+		post_manager->capacity = capacity;
+	}
+
+	set_post_slot(post_manager, post_manager->id_counter,
+				  post_manager->n_posts);
+	post_manager->posts[post_manager->n_posts] = post_tree;
+	ls_init(&post_manager->reposters[post_manager->n_posts],
+			&post_tree->arena);
+	int user_id = get_user_id(name);
+	info *g_node_data  = create_info(post_tree, post_manager->id_counter,
+									 user_id, title);
+	insert_node(post_tree, g_node_data, 0);
 	free(g_node_data);
+	/* The IDs only grow, so the list of the author stays sorted */
+	if (user_id >= 0)
+		iv_push_back(author_posts(post_manager, user_id),
+					 post_manager->id_counter);
 	post_manager->id_counter++;
 	post_manager->n_posts++;
 	printf("Created %s for %s\n", title, name);
@@ -21,14 +317,16 @@ void create_post(tree_post_manager *post_manager, char *name, char *title)
 
 g_tree_t *search_g_tree(tree_post_manager *post_manager, int post_id)
 {
-	if (post_manager->n_posts == 0)
+	if (post_id < 0 || post_id >= post_manager->n_post_slots)
 		return NULL;
 
-	for (int i = 0; i < post_manager->n_posts; i++) {
-		if (((info *)post_manager->posts[i]->root->data)->id == post_id)
-			return post_manager->posts[i];
-	}
-	return NULL;
+	int slot = post_manager->post_slots[post_id];
+
+	/* Only the posts have a slot, the other ids belong to reposts */
+	if (slot < 0)
+		return NULL;
+
+	return post_manager->posts[slot];
 }
 
 void create_repost(tree_post_manager *post_manager, char *name,
@@ -39,8 +337,9 @@ void create_repost(tree_post_manager *post_manager, char *name,
 	if (!post_tree)
 		return;
 
-	info *g_node_data  = create_info(post_manager->id_counter,
-									 get_user_id(name), NULL);
+	int user_id = get_user_id(name);
+	info *g_node_data  = create_info(post_tree, post_manager->id_counter,
+									 user_id, NULL);
 
 	if (repost_id == 0)
 		insert_node(post_tree, g_node_data, post_id);
@@ -48,29 +347,49 @@ void create_repost(tree_post_manager *post_manager, char *name,
 		insert_node(post_tree, g_node_data, repost_id);
 
 	free(g_node_data);
+	if (user_id >= 0)
+		index_repost(post_manager, user_id, post_id,
+					 post_manager->id_counter);
 
 	printf("Created repost #%d for %s\n", post_manager->id_counter, name);
 
 	post_manager->id_counter++;
 }
 
+typedef struct {
+	int *euler_vector; /* IDs of the tour. */
+	int *level_vector; /* Levels of the tour. */
+	int *index; /* Next position of the tour. */
+	int level; /* Level of the root of the walk. */
+} euler_walk_t;
+
+static void euler_append(euler_walk_t *walk, g_node_t *node, int level)
+{
+	walk->euler_vector[*walk->index] = ((info *)node->data)->id;
+	walk->level_vector[*walk->index] = walk->level + level;
+	(*walk->index)++;
+}
+
+static int euler_enter(g_node_t *node, int level, void *arg)
+{
+	euler_append(arg, node, level);
+	return 0;
+}
+
+/* The tour goes back to the parent after every child */
+static int euler_leave(g_node_t *node, int level, void *arg)
+{
+	if (level > 0)
+		euler_append(arg, node->parent, level - 1);
+	return 0;
+}
+
 void create_euler_representation(g_node_t *node, int *euler_vector,
 								 int *level_vector, int *index, int level)
 {
-	if (!node)
-		return;
-
-	euler_vector[*index] = ((info *)node->data)->id;
-	level_vector[*index] = level;
-	(*index)++;
+	euler_walk_t walk = {euler_vector, level_vector, index, level};
 
-	for (int i = 0; i < node->n_children; i++) {
-		create_euler_representation(node->children[i], euler_vector,
-									level_vector, index, level + 1);
-		euler_vector[*index] = ((info *)node->data)->id;
-		level_vector[*index] = level;
-		(*index)++;
-	}
+	g_tree_walk(node, euler_enter, euler_leave, &walk);
 }
 
 int search_lca(int *euler_vector, int *level_vector,
@@ -112,19 +431,14 @@ void common_repost(tree_post_manager *post_manager, int post_id,
 	if (!post_tree)
 		return;
 
-	int vector_length = 2 * count_tree_nodes(post_tree);
-	int *euler_vector = calloc(vector_length, sizeof(int));
-	DIE(!euler_vector, "calloc failed\n");
-	int *level_vector = calloc(vector_length, sizeof(int));
-	DIE(!level_vector, "calloc failed\n");
-	int level = 0;
-	int index = 0;
-	create_euler_representation(post_tree->root, euler_vector, level_vector,
-								&index, level);
-	int lca_id = search_lca(euler_vector, level_vector, repost_id_1,
-							repost_id_2);
-	free(euler_vector);
-	free(level_vector);
+	g_node_t *node_1 = search_node(post_tree, repost_id_1);
+	g_node_t *node_2 = search_node(post_tree, repost_id_2);
+
+	if (!node_1 || !node_2)
+		return;
+
+	int lca_id = ((info *)tree_lca(post_tree, node_1, node_2)->data)->id;
+
 	printf("The first common repost of %d and %d is %d\n",
 		   repost_id_1, repost_id_2, lca_id);
 }
@@ -140,66 +454,56 @@ void like_post(tree_post_manager *post_manager, char *name,
 	int user_id = get_user_id(name);
 	char *title = ((info *)post_tree->root->data)->title;
 
-	linked_list_t *g_node_list;
 	g_node_t *g_node;
-	if (repost_id == 0) {
-		g_node_list = ((info *)post_tree->root->data)->likes;
-	} else {
+	if (repost_id == 0)
+		g_node = post_tree->root;
+	else
 		g_node = search_node(post_tree, repost_id);
-		g_node_list = ((info *)g_node->data)->likes;
-	}
-	ll_node_t *prev_node = get_previous_node(g_node_list,
-											 &user_id, compare_ints);
-	if (!prev_node) {
-		ll_add_nth_node(g_node_list, g_node_list->size, &user_id);
-		if (repost_id == 0) {
-			((info *)post_tree->root->data)->n_likes++;
-			printf("User %s liked post %s\n", name, title);
-		} else {
-			((info *)g_node->data)->n_likes++;
-			printf("User %s liked repost %s\n", name, title);
-		}
+
+	if (!g_node)
+		return;
+
+	info *liked = g_node->data;
+	int old_n_likes = liked->n_likes;
+	int added = ls_toggle(&liked->likes, user_id);
+
+	if (added < 0)
+		return;
+	liked->n_likes = ls_size(&liked->likes);
+	update_max_likes(g_node, old_n_likes);
+
+	printf("User %s %s %s %s\n", name, added ? "liked" : "unliked",
+		   repost_id == 0 ? "post" : "repost", title);
+}
+
+typedef struct {
+	int *max_likes; /* Most likes found so far. */
+	int *max_likes_id; /* Smallest ID with max_likes likes. */
+} max_likes_walk_t;
+
+static int max_likes_visit(g_node_t *node, int level, void *arg)
+{
+	max_likes_walk_t *walk = arg;
+
+	(void)level;
+	if (((info *)node->data)->n_likes > *walk->max_likes) {
+		*walk->max_likes = ((info *)node->data)->n_likes;
+		*walk->max_likes_id = ((info *)node->data)->id;
 	} else {
-		ll_node_t *removed_node;
-		if (*((int *)g_node_list->head->data) == user_id) {
-			removed_node = ll_remove_nth_node(g_node_list, 0);
-			free(removed_node->data);
-			free(removed_node);
-		} else {
-			removed_node = prev_node->next;
-			prev_node->next = prev_node->next->next;
-			free(removed_node->data);
-			free(removed_node);
-			g_node_list->size--;
-		}
-		if (repost_id == 0) {
-			((info *)post_tree->root->data)->n_likes--;
-			printf("User %s unliked post %s\n", name, title);
-		} else {
-			((info *)g_node->data)->n_likes--;
-			printf("User %s unliked repost %s\n", name, title);
+		if (((info *)node->data)->n_likes == *walk->max_likes) {
+			if (((info *)node->data)->id < *walk->max_likes_id)
+				*walk->max_likes_id = ((info *)node->data)->id;
 		}
 	}
+	return 0;
 }
 
 void find_max_likes_recursively(g_node_t *node, int *max_likes,
 								int *max_likes_id)
 {
-	if (!node)
-		return;
+	max_likes_walk_t walk = {max_likes, max_likes_id};
 
-	if (((info *)node->data)->n_likes > *max_likes) {
-		*max_likes = ((info *)node->data)->n_likes;
-		*max_likes_id = ((info *)node->data)->id;
-	} else {
-		if (((info *)node->data)->n_likes == *max_likes) {
-			if (((info *)node->data)->id < *max_likes_id)
-				*max_likes_id = ((info *)node->data)->id;
-		}
-	}
-
-	for (int i = 0; i < node->n_children; i++)
-		find_max_likes_recursively(node->children[i], max_likes, max_likes_id);
+	g_tree_walk(node, max_likes_visit, NULL, &walk);
 }
 
 void post_ratio(tree_post_manager *post_manager, int post_id)
@@ -209,12 +513,8 @@ void post_ratio(tree_post_manager *post_manager, int post_id)
 	if (!post_tree)
 		return;
 
-	int max_likes = ((info *)post_tree->root->data)->n_likes;
-	int max_likes_id = ((info *)post_tree->root->data)->id;
-
-	g_node_t *root = post_tree->root;
-
-	find_max_likes_recursively(root, &max_likes, &max_likes_id);
+	/* The root holds the max likes of the whole tree */
+	int max_likes_id = ((info *)post_tree->root->data)->max_likes_id;
 
 	if (max_likes_id == ((info *)post_tree->root->data)->id)
 		printf("The original post is the highest rated\n");
@@ -222,6 +522,77 @@ void post_ratio(tree_post_manager *post_manager, int post_id)
 		printf("Post %d got ratio'd by repost %d\n", post_id, max_likes_id);
 }
 
+/* A repost of a deleted subtree, to be removed from the list of its user */
+typedef struct {
+	int user_id; /* Author of the repost. */
+	int repost_id; /* ID of the repost. */
+} deleted_repost_t;
+
+typedef struct {
+	deleted_repost_t *reposts; /* Reposts of the subtree. */
+	int size; /* Number of reposts. */
+	int capacity; /* Number of allocated entries. */
+} unindex_walk_t;
+
+static int unindex_visit(g_node_t *node, int level, void *arg)
+{
+	unindex_walk_t *walk = arg;
+	info *data = node->data;
+
+	(void)level;
+	/* The root is the post itself, not a repost */
+	if (!node->parent || data->user_id < 0)
+		return 0;
+
+	if (walk->size == walk->capacity) {
+		int capacity = walk->capacity ? 2 * walk->capacity : 16;
+		deleted_repost_t *reposts = realloc(walk->reposts,
+											capacity * sizeof(*reposts));
+
+		DIE(!reposts, "realloc failed");
+		walk->reposts = reposts;
+		walk->capacity = capacity;
+	}
+	walk->reposts[walk->size++] = (deleted_repost_t){data->user_id, data->id};
+	return 0;
+}
+
+static int compare_deleted(const void *a, const void *b)
+{
+	const deleted_repost_t *x = a, *y = b;
+
+	if (x->user_id != y->user_id)
+		return x->user_id < y->user_id ? -1 : 1;
+	return (x->repost_id > y->repost_id) - (x->repost_id < y->repost_id);
+}
+
+/*
+ * Removes the reposts of a subtree from the lists of their users: they are
+ * collected by a scan of the subtree and grouped by user, so the list of
+ * every user is compacted once
+ */
+static void unindex_subtree(tree_post_manager *post_manager, int post_id,
+							g_node_t *node)
+{
+	unindex_walk_t walk = {NULL, 0, 0};
+
+	g_subtree_scan(node, unindex_visit, &walk);
+	qsort(walk.reposts, walk.size, sizeof(*walk.reposts), compare_deleted);
+
+	int *repost_ids = malloc((walk.size + 1) * sizeof(*repost_ids));
+
+	DIE(!repost_ids, "malloc failed");
+	for (int i = 0; i < walk.size;) {
+		int user_id = walk.reposts[i].user_id, n = 0;
+
+		for (; i < walk.size && walk.reposts[i].user_id == user_id; i++)
+			repost_ids[n++] = walk.reposts[i].repost_id;
+		unindex_reposts(post_manager, user_id, post_id, repost_ids, n);
+	}
+	free(repost_ids);
+	free(walk.reposts);
+}
+
 void delete_post(tree_post_manager *post_manager, int post_id, int repost_id)
 {
 	g_tree_t *post_tree = search_g_tree(post_manager, post_id);
@@ -230,23 +601,27 @@ void delete_post(tree_post_manager *post_manager, int post_id, int repost_id)
 		return;
 
 	if (repost_id == 0) {
-		int pos = -1;
-		for (int i = 0; i < post_manager->n_posts; i++) {
-			if (((info *)post_manager->posts[i]->root->data)->id == post_id) {
-				pos = i;
-				break;
-			}
-		}
+		int user_id = ((info *)post_tree->root->data)->user_id;
+
 		printf("Deleted %s\n", ((info *)post_tree->root->data)->title);
 		free_g_tree(post_tree);
-		for (int i = pos; i < post_manager->n_posts - 1; i++)
-			post_manager->posts[i] = post_manager->posts[i + 1];
 
-		post_manager->posts[post_manager->n_posts - 1] = NULL;
-		post_manager->n_posts--;
+		if (user_id >= 0)
+			iv_remove_sorted(author_posts(post_manager, user_id), post_id);
+
+		post_manager->posts[post_manager->post_slots[post_id]] = NULL;
+		post_manager->post_slots[post_id] = -1;
+		post_manager->n_deleted++;
+		if (2 * post_manager->n_deleted >= post_manager->n_posts)
+			compact_posts(post_manager);
 	} else {
 		printf("Deleted repost #%d of post %s\n", repost_id,
 			   ((info *)post_tree->root->data)->title);
+
+		g_node_t *node = search_node(post_tree, repost_id);
+
+		if (node)
+			unindex_subtree(post_manager, post_id, node);
 		delete_subtree(post_tree, repost_id);
 	}
 }
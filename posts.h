@@ -1,23 +1,112 @@
 #ifndef POSTS_H
 #define POSTS_H
 
-#define MAX_G_TREES 100
-
 #include "generic_tree.h"
 
+/* Number of slots of the post table when the first post is created */
+#define MIN_POST_SLOTS 16
+
+/**
+ * @brief A repost in the list of reposts of a user.
+ */
+typedef struct {
+	int post_id; /* ID of the original post. */
+	int repost_id; /* ID of the repost. */
+} repost_entry_t;
+
+/**
+ * @brief Reposts of a user. A new repost is appended; the list is sorted by
+ * post ID, then by repost ID, when it is read or when reposts are deleted
+ * from it. The entries of a deleted post are only dropped when the list is
+ * read, since the ID of a deleted post is never given again.
+ */
+typedef struct {
+	repost_entry_t *data; /* The reposts. */
+	unsigned int size; /* Number of reposts. */
+	unsigned int capacity; /* Number of allocated entries. */
+	int sorted; /* 1 if the reposts are sorted. */
+} repost_list_t;
+
 /**
  * @brief Manages the collection of posts.
+ * The posts are kept in creation order in a table that doubles when it is
+ * full. Deleting a post only leaves a tombstone (a NULL slot); the table is
+ * compacted once half of its used slots are tombstones, so the cost of the
+ * compaction is spread over the deletes that caused it.
  */
 typedef struct {
-	g_tree_t **posts;    /* Array of pointers to posts (generic trees) */
-	int n_posts;         /* Number of posts */
+	g_tree_t **posts;    /* Posts in creation order, NULL for a deleted one */
+	int n_posts;         /* Number of used slots, tombstones included */
+	int capacity;        /* Number of allocated slots */
+	int n_deleted;       /* Number of tombstones */
+	like_set_t *reposters; /* Users who reposted the post of every slot,
+	allocated from the arena of the post */
+	int *post_slots;     /* Slot of every post, indexed by the post ID,
+	-1 for the IDs that are not live posts */
+	int n_post_slots;    /* Number of entries of post_slots */
+	int_vector_t *author_posts; /* IDs of the live posts of every user,
+	in creation order (so sorted) */
+	repost_list_t *user_reposts; /* Reposts of every user */
+	int n_users;         /* Number of entries of author_posts and
+	user_reposts */
 	int id_counter;      /* Counter for generating unique post IDs */
 } tree_post_manager;
 
+/**
+ * @brief Creates an empty post manager.
+ *
+ * @return The post manager.
+ */
+tree_post_manager *create_post_manager(void);
+
+/**
+ * @brief Frees a post manager and all its posts.
+ *
+ * @param post_manager The post manager.
+ */
+void free_post_manager(tree_post_manager *post_manager);
+
+/**
+ * @brief Gets the IDs of the live posts of a user, in creation order,
+ * which is also ascending ID order.
+ *
+ * @param post_manager The post manager.
+ * @param user_id The ID of the user.
+ * @param n_posts Set to the number of posts of the user.
+ * @return The IDs of the posts, NULL if the user has none.
+ */
+const int *get_author_posts(const tree_post_manager *post_manager,
+							int user_id, int *n_posts);
+
+/**
+ * @brief Gets the set of the users who reposted a post.
+ *
+ * @param post_manager The post manager.
+ * @param post_id The ID of the post.
+ * @return The set, NULL if there is no post with this ID.
+ */
+const like_set_t *get_reposters(const tree_post_manager *post_manager,
+								int post_id);
+
+/**
+ * @brief Gets the reposts of a user, sorted by post ID, so in the creation
+ * order of the posts, then by repost ID. The reposts of the posts that were
+ * deleted since the last call are dropped first.
+ *
+ * @param post_manager The post manager.
+ * @param user_id The ID of the user.
+ * @param n_reposts Set to the number of reposts of the user.
+ * @return The reposts, NULL if the user has none.
+ */
+const repost_entry_t *get_user_reposts(tree_post_manager *post_manager,
+									   int user_id, int *n_reposts);
+
 /**
  * @brief Creates a new post.
- * Initialize a new tree structure for the post and store it in the
- * post manager's posts array.
+ * Initialize a new tree structure for the post and append it to the
+ * post manager's table of posts, growing the table if it is full, and
+ * record its slot under its ID.
+ * Append its ID to the list of posts of its author.
  * Create a new information node containing the post's ID, the user's ID,
  * and the post's title.
  * Insert the newly created information node into the initialized post tree.
@@ -32,12 +121,9 @@ void create_post(tree_post_manager *post_manager, char *name, char *title);
 
 /**
  * @brief Searches for a post with the given ID.
- * Check if there are no posts in the post manager. If there are no posts,
+ * Look the slot of the ID up in the post manager, in O(1).
+ * If the ID is unknown, belongs to a deleted post or to a repost,
  * return NULL.
- * Loop through each post in the post manager.
- * For each post, compare its ID with the provided post ID.
- * If a matching post ID is found, return the corresponding tree.
- * If no matching post ID is found after checking all posts, return NULL.
  *
  * @param post_manager The post manager containing all posts.
  * @param post_id The ID of the post to search for.
@@ -53,6 +139,8 @@ g_tree_t *search_g_tree(tree_post_manager *post_manager, int post_id);
  * the user's ID, and NULL for the title.
  * Insert the newly created repost information node into the post tree.
  * If repost_id is provided, insert the repost under the specified parent node.
+ * Add the repost to the list of reposts of the user, and the user to the
+ * set of reposters of the post.
  * Print a confirmation message indicating that the repost has been created.
  * Increment the post manager's ID counter to ensure uniqueness of repost IDs.
  *
@@ -67,14 +155,11 @@ void create_repost(tree_post_manager *post_manager, char *name,
 
 /**
  * @brief Creates an Euler tour representation of the repost tree.
- * Base Case: If the current node is NULL, the function returns.
- * Store the node's ID and its level in the respective arrays
- * at the current index.
- * Recursively call the function for each child node, updating the
- * index and level.
- *
- * After processing all children, store the node's ID and level again
- * in the arrays before returning.
+ * If the node is NULL, the function returns.
+ * Walk the tree with g_tree_walk(). Store the ID and the level of every
+ * node in the respective arrays at the current index when the walk enters
+ * it, and store its parent again after it, so that the tour goes back to
+ * the parent after every child.
  *
  * @param node The current node in the repost tree.
  * @param euler_vector The array to store the Euler tour.
@@ -108,13 +193,10 @@ int search_lca(int *euler_vector, int *level_vector,
  * @brief Finds the first common repost between two reposts of a post
  * using the lowest common ancestor algorithm.
  * Search for the post with the given ID in the post manager's tree structure.
- * Allocate memory for arrays to store the Euler tour representation and
- * level vectors of the post tree.
- * Create the Euler tour representation and level vectors of the post tree
- * using a recursive function.
- * Find the LCA of the two reposts using their IDs and the Euler tour
- * representation and level vectors.
- * Free the allocated memory for the arrays.
+ * Look both reposts up in the id index of the trees.
+ * Find their LCA with tree_lca(): by binary lifting over the jump tables of
+ * the nodes in O(log depth), or in O(1) with the Euler tour cache of the
+ * tree once the tree gets bursts of queries between changes.
  * Print the ID of the first common repost of the given reposts.
  *
  * @param post_manager The post manager.
@@ -131,12 +213,9 @@ void common_repost(tree_post_manager *post_manager, int post_id,
  * Get the user ID corresponding to the given user name.
  * If the post is a repost, get the title of the original post;
  * otherwise, get its title.
- *  Determine the linked list of likes based on whether the user is liking
- * the original post or a repost.
- * Check if the user has previously liked the post or repost.
- * If not, add the user to the like list and increment the like count.
- * If the user has previously liked the post, remove their like from
- * the like list and decrement the like count.
+ * Toggle the user in the like set of the post or repost: add them if they
+ * did not like it yet, remove them otherwise. This is O(1), and the like
+ * count is then read back from the set, so it always matches it.
  * Print a confirmation message indicating whether the user liked or unliked
  * the post or repost.
  *
@@ -149,16 +228,15 @@ void like_post(tree_post_manager *post_manager, char *name,
 			   int post_id, int repost_id);
 
 /**
- * @brief Recursively finds the node with the maximum number of likes.
- * Base Case: If the current node is NULL, the function returns.
- * Compare the number of likes of the current node with the maximum likes
- * found so far. If the current node has more likes, update the maximum likes
- * and the corresponding node ID.
+ * @brief Finds the node with the maximum number of likes.
+ * If the node is NULL, the function returns.
+ * Walk the subtree with g_tree_walk(). For every node, compare the number
+ * of likes of the current node with the maximum likes found so far.
+ * If the current node has more likes, update the maximum likes and the
+ * corresponding node ID.
  * If the number of likes of the current node equals the maximum likes
  * found so far, compare the IDs of the nodes. If the current node has
  * a smaller ID, update the maximum likes ID.
- * Recursively call the function for each child node
- * to explore the entire tree.
  *
  * @param node The current node in the tree.
  * @param max_likes Pointer to store the maximum number of likes.
@@ -172,10 +250,10 @@ void find_max_likes_recursively(g_node_t *node, int *max_likes,
  * @brief Finds the post or repost with the highest number of likes.
  * Search for the specified post ID in the post manager's tree structure.
  * If the post does not exist, the function returns.
- * Initialize variables to store the maximum number of likes and the ID of
- * the post with the maximum likes.
- * Recursively traverse the tree to find the node with the maximum number of
- * likes and update the variables accordingly.
+ * Read the ID of the post or repost with the maximum number of likes from
+ * the root: every node keeps the max likes of its subtree (the smallest ID
+ * among ties), updated by like_post(), insert_node() and delete_subtree(),
+ * so no node is visited.
  * Determine ratio result: Compare the ID of the post with the maximum likes
  * to the ID of the original post.
  * Print a message indicating whether the original post has the highest number
@@ -192,16 +270,21 @@ void post_ratio(tree_post_manager *post_manager, int post_id);
  * If the post does not exist, the function returns.
  * Delete Post or Repost:
  * If repost_id is 0, indicating the deletion of the original post:
- *		- find the position of the post in the post manager's array of posts.
  *		- print a confirmation message indicating the deletion of the post.
  *		- free the memory associated with the post's tree structure.
- *		- shift the remaining posts in the array to fill the gap left by
- *		the deleted post.
- *		- decrement the count of posts in the post manager.
+ *		- leave a tombstone in its slot of the table and forget its ID.
+ *		- remove its ID from the list of posts of its author.
+ *		- compact the table once half of its used slots are tombstones.
  * If repost_id is not 0, indicating the deletion of a repost:
  *		- print a confirmation message indicating the deletion of the repost.
+ *		- remove every repost of the subtree from the list of reposts of its
+ *		user, and the user from the reposters of the post if it was their
+ *		last repost of it.
  *		- call the delete_subtree function to delete the subtree rooted at the
  *		repost node.
+ * The reposts of a deleted post are dropped from the lists of their users
+ * the next time these lists are read, and its set of reposters is released
+ * with its arena.
  *
  * @param post_manager The post manager.
  * @param post_id The ID of the original post.
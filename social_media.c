@@ -9,6 +9,8 @@
 #include "friends.h"
 #include "posts.h"
 #include "feed.h"
+#include "workspace.h"
+#include "timeline.h"
 
 /**
  * Initializez every task based on which task we are running
@@ -39,12 +41,8 @@ int main(void)
 
 	init_tasks();
 
-	list_graph_t *graph = lg_create(MAX_PEOPLE);
-	tree_post_manager *post_manager = calloc(1, sizeof(tree_post_manager));
-	post_manager->posts = calloc(MAX_G_TREES, sizeof(g_tree_t *));
-	DIE(!post_manager->posts, "calloc failed\n");
-	post_manager->n_posts = 0;
-	post_manager->id_counter = 1;
+	list_graph_t *graph = lg_create(get_users_number());
+	tree_post_manager *post_manager = create_post_manager();
 
 	char *input = (char *)malloc(MAX_COMMAND_LEN);
 	while (1) {
@@ -54,6 +52,10 @@ int main(void)
 		if (!command)
 			break;
 
+		// New users get a node in the friendship graph right away
+		if (handle_input_users(input))
+			lg_grow(graph, get_users_number());
+
 		#ifdef TASK_1
 		handle_input_friends(input, graph);
 		#endif
@@ -66,12 +68,15 @@ int main(void)
 		handle_input_feed(input, graph, post_manager);
 		#endif
 	}
-	for (int i = 0; i < post_manager->n_posts; i++)
-		free_g_tree(post_manager->posts[i]);
-	free(post_manager->posts);
-	free(post_manager);
+	free_post_manager(post_manager);
+	free_g_index();
 
 	lg_free(graph);
+	ws_free();
+	tl_free();
+	#ifdef TASK_3
+	free_feed_cache();
+	#endif
 
 	free_users();
 	free(input);
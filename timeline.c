@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "int_vector.h"
+#include "timeline.h"
+
+/* Timeline of every user, indexed by user id */
+static timeline_t *timelines;
+static int n_timelines;
+
+timeline_t *tl_get(int user_id)
+{
+	if (user_id < 0 || user_id >= n_timelines ||
+		!timelines[user_id].entries)
+		return NULL;
+
+	return &timelines[user_id];
+}
+
+timeline_t *tl_create(int user_id)
+{
+	if (user_id >= n_timelines) {
+		int n_users = n_timelines ? n_timelines : 64;
+
+		while (n_users <= user_id)
+			n_users *= 2;
+
+		timeline_t *grown = realloc(timelines, n_users * sizeof(*grown));
+
+		DIE(!grown, "realloc timelines failed");
+		memset(grown + n_timelines, 0,
+			   (n_users - n_timelines) * sizeof(*grown));
+		timelines = grown;
+		n_timelines = n_users;
+	}
+
+	timeline_t *tl = &timelines[user_id];
+
+	if (!tl->entries) {
+		tl->entries = malloc(TL_CAPACITY * sizeof(*tl->entries));
+		DIE(!tl->entries, "malloc timeline failed");
+	}
+	tl->head = 0;
+	tl->size = 0;
+	tl->horizon = 0;
+
+	return tl;
+}
+
+void tl_drop(int user_id)
+{
+	timeline_t *tl = tl_get(user_id);
+
+	if (tl) {
+		free(tl->entries);
+		tl->entries = NULL;
+	}
+}
+
+void tl_push(timeline_t *tl, int post_id, int user_id)
+{
+	if (tl->size == TL_CAPACITY) {
+		tl->horizon = tl->entries[tl->head].post_id;
+		tl->head = (tl->head + 1) % TL_CAPACITY;
+		tl->size--;
+	}
+
+	tl_entry_t *entry = &tl->entries[(tl->head + tl->size) % TL_CAPACITY];
+
+	entry->post_id = post_id;
+	entry->user_id = user_id;
+	tl->size++;
+}
+
+int tl_merge(timeline_t *tl, const int *post_ids, int n_posts, int user_id)
+{
+	tl_entry_t *merged = malloc(TL_CAPACITY * sizeof(*merged));
+	unsigned int pos = TL_CAPACITY, i = 0;
+	int j = n_posts - 1, added = 0;
+
+	DIE(!merged, "malloc timeline failed");
+
+	/* Fill the new ring from its newest entry, while there is room */
+	while (i < tl->size || (j >= 0 && post_ids[j] > tl->horizon)) {
+		const tl_entry_t *entry = i < tl->size ? tl_newest(tl, i) : NULL;
+		int post_id = j >= 0 && post_ids[j] > tl->horizon ? post_ids[j] : 0;
+		int newest = entry && entry->post_id >= post_id ?
+					 entry->post_id : post_id;
+
+		if (pos == 0) {
+			/* Every post that does not fit is older than the ones kept */
+			tl->horizon = newest;
+			break;
+		}
+
+		pos--;
+		if (entry && entry->post_id == newest) {
+			merged[pos] = *entry;
+			i++;
+			/* A post that is already there is not added again */
+			if (post_id == newest)
+				j--;
+		} else {
+			merged[pos] = (tl_entry_t){post_id, user_id};
+			j--;
+			added++;
+		}
+	}
+
+	free(tl->entries);
+	tl->entries = merged;
+	tl->head = pos % TL_CAPACITY;
+	tl->size = TL_CAPACITY - pos;
+
+	return added;
+}
+
+int tl_remove_if(timeline_t *tl, int (*drop)(const tl_entry_t *entry,
+											 void *arg), void *arg)
+{
+	unsigned int size = 0;
+
+	for (unsigned int i = 0; i < tl->size; i++) {
+		tl_entry_t entry = tl->entries[(tl->head + i) % TL_CAPACITY];
+
+		if (!drop(&entry, arg))
+			tl->entries[(tl->head + size++) % TL_CAPACITY] = entry;
+	}
+
+	int removed = tl->size - size;
+
+	tl->size = size;
+	return removed;
+}
+
+void tl_free(void)
+{
+	for (int i = 0; i < n_timelines; i++)
+		free(timelines[i].entries);
+	free(timelines);
+	timelines = NULL;
+	n_timelines = 0;
+}
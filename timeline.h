@@ -0,0 +1,114 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+/* Number of posts kept in the timeline of a user */
+#define TL_CAPACITY 64
+
+typedef struct tl_entry_t tl_entry_t;
+typedef struct timeline_t timeline_t;
+
+/**
+ * @struct tl_entry_t
+ * @brief A post in a timeline.
+ */
+struct tl_entry_t
+{
+	int post_id; /* ID of the post. */
+	int user_id; /* Author of the post. */
+};
+
+/**
+ * @struct timeline_t
+ * @brief Newest posts of the feed of a user (their own posts and the posts
+ * of their friends), pushed when they are created. The timeline is a ring
+ * of TL_CAPACITY entries sorted by post ID: pushing a post into a full
+ * timeline drops its oldest entry and moves the horizon up to it. Every
+ * post of the authors of the feed that is newer than the horizon is in the
+ * timeline (or was deleted), so the timeline can serve any feed it holds
+ * enough posts for.
+ */
+struct timeline_t
+{
+	tl_entry_t *entries; /* Ring of TL_CAPACITY entries. */
+	unsigned int head; /* Position of the oldest entry. */
+	unsigned int size; /* Number of entries. */
+	int horizon; /* Newest post ID that was dropped, 0 if none was. */
+};
+
+/**
+ * Gets the timeline of a user, if it was created.
+ *
+ * @param user_id - The user.
+ * @return The timeline, or NULL if the user has none.
+ */
+timeline_t *tl_get(int user_id);
+
+/**
+ * Creates an empty timeline for a user, replacing the one they had.
+ *
+ * @param user_id - The user, not negative.
+ * @return The timeline.
+ */
+timeline_t *tl_create(int user_id);
+
+/**
+ * Frees the timeline of a user, if they have one.
+ *
+ * @param user_id - The user.
+ */
+void tl_drop(int user_id);
+
+/**
+ * Gets an entry of a timeline, counting from the newest one.
+ *
+ * @param tl - The timeline.
+ * @param i - The position from the newest entry (0 .. size - 1).
+ * @return The entry.
+ */
+static inline const tl_entry_t *tl_newest(const timeline_t *tl,
+										  unsigned int i)
+{
+	return &tl->entries[(tl->head + tl->size - 1 - i) % TL_CAPACITY];
+}
+
+/**
+ * Pushes a post newer than every post of the timeline. If the timeline is
+ * full, its oldest entry is dropped.
+ *
+ * @param tl - The timeline.
+ * @param post_id - The post.
+ * @param user_id - The author of the post.
+ */
+void tl_push(timeline_t *tl, int post_id, int user_id);
+
+/**
+ * Adds the posts of a new author of the feed, keeping the timeline sorted.
+ * Only the posts newer than the horizon are added; if the timeline
+ * overflows, the oldest entries are dropped and the horizon moves up.
+ *
+ * @param tl - The timeline.
+ * @param post_ids - The posts of the author, in ascending ID order.
+ * @param n_posts - The number of posts.
+ * @param user_id - The author.
+ * @return The number of posts of the author that were added.
+ */
+int tl_merge(timeline_t *tl, const int *post_ids, int n_posts, int user_id);
+
+/**
+ * Removes the entries for which drop returns 1, keeping the order of the
+ * others. The horizon does not change.
+ *
+ * @param tl - The timeline.
+ * @param drop - Called on every entry.
+ * @param arg - Passed to drop.
+ * @return The number of removed entries.
+ */
+int tl_remove_if(timeline_t *tl, int (*drop)(const tl_entry_t *entry,
+											 void *arg), void *arg);
+
+/**
+ * Frees every timeline.
+ */
+void tl_free(void);
+
+#endif /* TIMELINE_H */
@@ -2,50 +2,233 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 static const char *db_path = "users.db";
 
+/*
+ * All the names from users.db live in one contiguous arena, separated by
+ * '\0'. users[id] points inside it, so the whole directory is released with
+ * a few free() calls. Names added at runtime by register_user() are bump
+ * allocated from a chain of extra blocks, so registering never moves the
+ * names that are already handed out.
+ */
+#define NAME_BLOCK_SIZE 65536
+
+typedef struct name_block name_block;
+struct name_block {
+	name_block *next; /* Previously filled block. */
+	size_t used; /* Number of bytes already handed out. */
+	size_t size; /* Capacity of data. */
+	char data[]; /* The names. */
+};
+
+static char *names_arena;
+static name_block *name_blocks;
 static char **users;
-static uint16_t users_number;
+static uint32_t users_number;
+static uint32_t users_capacity;
 
-void init_users(void)
+/*
+ * Open addressing (linear probing) index from user names to user ids.
+ * Every slot stores id + 1, so 0 marks an empty slot. The full hash of each
+ * indexed name is kept next to it, so a probe only calls strcmp() when the
+ * hashes match.
+ */
+static uint32_t *index_slots;
+static uint32_t *index_hashes;
+static uint32_t index_mask;
+
+static user_index_stats index_stats;
+
+static uint32_t hash_name(const char *name)
 {
-	FILE *users_db = fopen(db_path, "r");
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
 
-	if (!users_db) {
-		perror("Error reading users.db");
-		return;
+	while (*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void index_insert(uint32_t id, uint32_t hash)
+{
+	uint32_t pos = hash & index_mask;
+
+	while (index_slots[pos])
+		pos = (pos + 1) & index_mask;
+
+	index_slots[pos] = id + 1;
+	index_hashes[pos] = hash;
+}
+
+void build_user_index(void)
+{
+	uint32_t capacity = 16;
+
+	/* Keep the load factor at or below 1/2 */
+	while (capacity < 2u * users_number)
+		capacity <<= 1;
+
+	free(index_slots);
+	free(index_hashes);
+
+	index_slots = calloc(capacity, sizeof(*index_slots));
+	DIE(!index_slots, "calloc index failed");
+	index_hashes = malloc(capacity * sizeof(*index_hashes));
+	DIE(!index_hashes, "malloc index failed");
+	index_mask = capacity - 1;
+
+	for (uint32_t i = 0; i < users_number; i++)
+		index_insert(i, hash_name(users[i]));
+}
+
+/*
+ * Splits the mapped users.db into names. The first token is the number of
+ * users, every following whitespace separated token is a name.
+ */
+static void parse_users(const char *db, size_t size)
+{
+	size_t pos = 0;
+	uint32_t expected = 0;
+
+	while (pos < size && isspace((unsigned char)db[pos]))
+		pos++;
+	while (pos < size && isdigit((unsigned char)db[pos])) {
+		uint32_t digit = db[pos++] - '0';
+
+		if (expected > (UINT32_MAX - digit) / 10)
+			expected = UINT32_MAX;
+		else
+			expected = expected * 10 + digit;
 	}
 
-	fscanf(users_db, "%hu", &users_number);
+	/* Each name takes a character and a separator, so cap the header count */
+	if (expected > (size - pos) / 2 + 1)
+		expected = (size - pos) / 2 + 1;
 
-	users = malloc(users_number * sizeof(char *));
+	/* Every name is followed by at most one '\0', so size + 1 is enough */
+	names_arena = malloc(size + 1);
+	DIE(!names_arena, "malloc names failed");
+	users_capacity = expected ? expected : 1;
+	users = malloc(users_capacity * sizeof(char *));
+	DIE(!users, "malloc users failed");
 
-	char temp[32];
-	for (uint16_t i = 0; i < users_number; i++) {
-		fscanf(users_db, "%s", temp);
-		int size = strlen(temp);
+	char *dst = names_arena;
 
-		users[i] = malloc(size + 1);
-		strcpy(users[i], temp);
+	users_number = 0;
+	while (users_number < expected) {
+		while (pos < size && isspace((unsigned char)db[pos]))
+			pos++;
+		if (pos == size)
+			break;
+
+		const char *name = db + pos;
+
+		while (pos < size && !isspace((unsigned char)db[pos]))
+			pos++;
+
+		memcpy(dst, name, db + pos - name);
+		users[users_number++] = dst;
+		dst += db + pos - name;
+		*dst++ = '\0';
 	}
+}
+
+int load_users_from(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	size_t size = st.st_size;
+	char *db = NULL;
 
-	fclose(users_db);
+	if (size) {
+		db = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (db == MAP_FAILED) {
+			close(fd);
+			return -1;
+		}
+		madvise(db, size, MADV_SEQUENTIAL);
+	}
+	close(fd);
+
+	/* Drop a previously loaded list instead of leaking its arena */
+	free_users();
+	parse_users(db, size);
+
+	if (db)
+		munmap(db, size);
+
+	return 0;
 }
 
-uint16_t get_user_id(char *name)
+int init_users_from(const char *path)
 {
-	if (!users)
+	if (load_users_from(path) < 0)
 		return -1;
 
-	for (uint16_t i = 0; i < users_number; i++)
-		if (!strcmp(users[i], name))
-			return i;
+	build_user_index();
+
+	return 0;
+}
 
-	return -1;
+void init_users(void)
+{
+	if (init_users_from(db_path) < 0)
+		perror("Error reading users.db");
 }
 
-char *get_user_name(uint16_t id)
+uint32_t get_user_id(char *name)
+{
+	if (!index_slots || !name)
+		return USER_NOT_FOUND;
+
+	uint32_t hash = hash_name(name);
+	uint32_t pos = hash & index_mask;
+	unsigned long probes = 1;
+
+	index_stats.lookups++;
+
+	while (index_slots[pos]) {
+		uint32_t id = index_slots[pos] - 1;
+
+		if (index_hashes[pos] == hash && !strcmp(users[id], name))
+			break;
+
+		pos = (pos + 1) & index_mask;
+		probes++;
+	}
+
+	index_stats.probes += probes;
+	if (probes > index_stats.max_probe)
+		index_stats.max_probe = probes;
+
+	if (!index_slots[pos]) {
+		index_stats.misses++;
+		return USER_NOT_FOUND;
+	}
+
+	return index_slots[pos] - 1;
+}
+
+char *get_user_name(uint32_t id)
 {
 	if (id >= users_number)
 		return NULL;
@@ -53,10 +236,118 @@ char *get_user_name(uint16_t id)
 	return users[id];
 }
 
+uint32_t get_users_number(void)
+{
+	return users_number;
+}
+
+static char *copy_name(const char *name)
+{
+	size_t len = strlen(name) + 1;
+
+	if (!name_blocks || name_blocks->size - name_blocks->used < len) {
+		size_t size = len > NAME_BLOCK_SIZE ? len : NAME_BLOCK_SIZE;
+		name_block *block = malloc(sizeof(*block) + size);
+
+		DIE(!block, "malloc name block failed");
+		block->next = name_blocks;
+		block->used = 0;
+		block->size = size;
+		name_blocks = block;
+	}
+
+	char *copy = name_blocks->data + name_blocks->used;
+
+	memcpy(copy, name, len);
+	name_blocks->used += len;
+
+	return copy;
+}
+
+uint32_t register_user(char *name)
+{
+	if (!name || !*name)
+		return USER_NOT_FOUND;
+
+	uint32_t id = get_user_id(name);
+
+	if (id != USER_NOT_FOUND)
+		return id;
+
+	if (users_number == USER_NOT_FOUND - 1)
+		return USER_NOT_FOUND;
+
+	if (users_number == users_capacity) {
+		users_capacity = users_capacity ? 2 * users_capacity : 16;
+		users = realloc(users, users_capacity * sizeof(char *));
+		DIE(!users, "realloc users failed");
+	}
+
+	id = users_number++;
+	users[id] = copy_name(name);
+
+	if (!index_slots || 2u * users_number > index_mask + 1)
+		build_user_index();
+	else
+		index_insert(id, hash_name(users[id]));
+
+	return id;
+}
+
+int handle_input_users(char *input)
+{
+	char *commands = strdup(input);
+	char *cmd = strtok(commands, "\n ");
+	int registered = 0;
+
+	if (cmd && !strcmp(cmd, "register")) {
+		char *name = strtok(NULL, "\n ");
+		uint32_t id = get_user_id(name);
+
+		if (id != USER_NOT_FOUND) {
+			printf("User %s already exists\n", name);
+		} else {
+			id = register_user(name);
+			if (id != USER_NOT_FOUND) {
+				printf("Registered %s with id %u\n", name, id);
+				registered = 1;
+			}
+		}
+	}
+
+	free(commands);
+	return registered;
+}
+
+void get_user_index_stats(user_index_stats *stats)
+{
+	if (stats)
+		*stats = index_stats;
+}
+
+void reset_user_index_stats(void)
+{
+	memset(&index_stats, 0, sizeof(index_stats));
+}
+
 void free_users(void)
 {
-	for (size_t i = 0; i < users_number; i++)
-		free(users[i]);
+	while (name_blocks) {
+		name_block *next = name_blocks->next;
 
+		free(name_blocks);
+		name_blocks = next;
+	}
+
+	free(names_arena);
 	free(users);
+	free(index_slots);
+	free(index_hashes);
+
+	names_arena = NULL;
+	users = NULL;
+	index_slots = NULL;
+	index_hashes = NULL;
+	users_number = 0;
+	users_capacity = 0;
 }
@@ -1,5 +1,11 @@
+#ifndef USERS_H
+#define USERS_H
+
 #include <stdint.h>
 
+/* Returned by the lookups below when a user does not exist */
+#define USER_NOT_FOUND ((uint32_t)-1)
+
 #define DIE(condition, message) \
 	do { \
 		if (condition) { \
@@ -9,17 +15,50 @@
 	} while (0)
 
 /**
- * Initializes the user list
+ * @brief Counters collected by the name -> id index used by get_user_id().
+ */
+typedef struct {
+	unsigned long lookups; /* Number of lookups served by the index. */
+	unsigned long probes; /* Total number of slots inspected by lookups. */
+	unsigned long max_probe; /* Longest probe sequence seen so far. */
+	unsigned long misses; /* Lookups for names that are not in users.db. */
+} user_index_stats;
+
+/**
+ * Initializes the user list and builds the name -> id index
 */
 void init_users(void);
 
+/**
+ * Loads the user list from the given database file and builds its name
+ * index. A previously loaded list is released first.
+ *
+ * @param path - Path of a file in the users.db format
+ * @return 0 on success, -1 if the file could not be read
+*/
+int init_users_from(const char *path);
+
+/**
+ * Loads the user list without building the name index. The file is memory
+ * mapped and its names are copied into a single contiguous arena.
+ *
+ * @param path - Path of a file in the users.db format
+ * @return 0 on success, -1 if the file could not be read
+*/
+int load_users_from(const char *path);
+
+/**
+ * Rebuilds the name index used by get_user_id() over the loaded users.
+*/
+void build_user_index(void);
+
 /**
  * Find the user_id of a user by it's name
  *
  * @param name - The name of the user
- * @return the id of the user, of -1 if name is not found
+ * @return the id of the user, of USER_NOT_FOUND if name is not found
 */
-uint16_t get_user_id(char *name);
+uint32_t get_user_id(char *name);
 
 /**
  * Find the user_id of a user by it's name
@@ -27,9 +66,48 @@ uint16_t get_user_id(char *name);
  * @param id - The id of a user
  * @return the name of a user, of NULL if not found
 */
-char *get_user_name(uint16_t id);
+char *get_user_name(uint32_t id);
 
 /**
- * Frees the user list
+ * Gets the number of loaded users
+ *
+ * @return the number of users
+*/
+uint32_t get_users_number(void);
+
+/**
+ * Adds a new user at the end of the user list. Ids are given in
+ * registration order, so the new user gets id get_users_number() - 1.
+ *
+ * @param name - The name of the new user
+ * @return the id of the user (the existing one if the name is already
+ * taken), or USER_NOT_FOUND if the name is empty
+*/
+uint32_t register_user(char *name);
+
+/**
+ * Handles the "register <name>" command
+ *
+ * @param input - The input line
+ * @return 1 if a new user was registered, 0 otherwise
+*/
+int handle_input_users(char *input);
+
+/**
+ * Copies the current lookup counters of the name -> id index
+ *
+ * @param stats - Where to store the counters
+*/
+void get_user_index_stats(user_index_stats *stats);
+
+/**
+ * Resets the lookup counters of the name -> id index
+*/
+void reset_user_index_stats(void);
+
+/**
+ * Frees the user list and its index
 */
 void free_users(void);
+
+#endif /* USERS_H */
@@ -0,0 +1,79 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "workspace.h"
+
+/* One workspace per thread, created on first use */
+static __thread query_workspace_t *thread_ws;
+
+query_workspace_t *ws_acquire(unsigned int nodes)
+{
+	query_workspace_t *ws = thread_ws;
+
+	if (!ws) {
+		ws = calloc(1, sizeof(*ws));
+		DIE(!ws, "calloc workspace failed");
+		thread_ws = ws;
+	}
+
+	if (nodes > ws->capacity) {
+		unsigned int capacity = ws->capacity ? ws->capacity : 64;
+
+		while (capacity < nodes)
+			capacity *= 2;
+
+		ws->stamp = realloc(ws->stamp, capacity * sizeof(*ws->stamp));
+		DIE(!ws->stamp, "realloc workspace failed");
+		ws->value = realloc(ws->value, capacity * sizeof(*ws->value));
+		DIE(!ws->value, "realloc workspace failed");
+		memset(ws->stamp + ws->capacity, 0,
+			   (capacity - ws->capacity) * sizeof(*ws->stamp));
+		ws->capacity = capacity;
+	}
+
+	/* Stamp 0 means "never set", so skip it when the epoch wraps around */
+	if (++ws->epoch == 0) {
+		memset(ws->stamp, 0, ws->capacity * sizeof(*ws->stamp));
+		ws->epoch = 1;
+	}
+	ws->touched.size = 0;
+
+	return ws;
+}
+
+int *ws_buffer(query_workspace_t *ws, int index, unsigned int size)
+{
+	iv_reserve(&ws->buffers[index], size);
+
+	return ws->buffers[index].data;
+}
+
+void *ws_scratch(query_workspace_t *ws, size_t size)
+{
+	if (size > ws->scratch_size) {
+		free(ws->scratch);
+		ws->scratch = malloc(size);
+		DIE(!ws->scratch, "malloc workspace failed");
+		ws->scratch_size = size;
+	}
+
+	return ws->scratch;
+}
+
+void ws_free(void)
+{
+	query_workspace_t *ws = thread_ws;
+
+	if (!ws)
+		return;
+
+	free(ws->stamp);
+	free(ws->value);
+	iv_free(&ws->touched);
+	for (int i = 0; i < WS_BUFFERS; i++)
+		iv_free(&ws->buffers[i]);
+	free(ws->scratch);
+	free(ws);
+	thread_ws = NULL;
+}
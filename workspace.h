@@ -0,0 +1,97 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <stddef.h>
+
+#include "int_vector.h"
+
+/* Number of scratch int arrays available to a query */
+#define WS_BUFFERS 2
+
+typedef struct query_workspace_t query_workspace_t;
+
+/**
+ * @struct query_workspace_t
+ * @brief Scratch memory reused by every graph and feed query of a thread.
+ * Every node has a value that is only valid if its stamp equals the epoch
+ * of the current query, so starting a new query is a single increment
+ * instead of clearing an array the size of the population. The nodes that
+ * got a value during the current query are listed in touched, so results
+ * can be emitted without scanning every node.
+ */
+struct query_workspace_t
+{
+	unsigned int epoch; /* Generation of the current query. */
+	unsigned int *stamp; /* Generation in which value[i] was last set. */
+	int *value; /* Value of every node for the current query. */
+	unsigned int capacity; /* Number of entries in stamp and value. */
+	int_vector_t touched; /* Nodes set during the current query. */
+	int_vector_t buffers[WS_BUFFERS]; /* Scratch int arrays. */
+	void *scratch; /* Untyped scratch memory. */
+	size_t scratch_size; /* Size of scratch in bytes. */
+};
+
+/**
+ * Gets the workspace of the calling thread and starts a new query in it:
+ * every node value reads as 0 again and the touched list is emptied.
+ * Only one query may use the workspace of a thread at a time.
+ *
+ * @param nodes - The number of nodes the query may touch.
+ * @return The workspace of the calling thread.
+ */
+query_workspace_t *ws_acquire(unsigned int nodes);
+
+/**
+ * Gets the value of a node in the current query.
+ *
+ * @param ws - The workspace.
+ * @param node - The node.
+ * @return The value of the node, or 0 if it was not set in this query.
+ */
+static inline int ws_get(const query_workspace_t *ws, int node)
+{
+	return ws->stamp[node] == ws->epoch ? ws->value[node] : 0;
+}
+
+/**
+ * Sets the value of a node in the current query. The first time a node is
+ * set in a query, it is added to the touched list.
+ *
+ * @param ws - The workspace.
+ * @param node - The node.
+ * @param value - The new value.
+ */
+static inline void ws_set(query_workspace_t *ws, int node, int value)
+{
+	if (ws->stamp[node] != ws->epoch) {
+		ws->stamp[node] = ws->epoch;
+		iv_push_back(&ws->touched, node);
+	}
+	ws->value[node] = value;
+}
+
+/**
+ * Gets one of the scratch int arrays of the workspace.
+ *
+ * @param ws - The workspace.
+ * @param index - Which array (0 .. WS_BUFFERS - 1).
+ * @param size - The minimum number of elements the array must hold.
+ * @return The array. Its contents are undefined.
+ */
+int *ws_buffer(query_workspace_t *ws, int index, unsigned int size);
+
+/**
+ * Gets untyped scratch memory from the workspace.
+ *
+ * @param ws - The workspace.
+ * @param size - The minimum size in bytes.
+ * @return The memory. Its contents are undefined.
+ */
+void *ws_scratch(query_workspace_t *ws, size_t size);
+
+/**
+ * Frees the workspace of the calling thread.
+ */
+void ws_free(void);
+
+#endif /* WORKSPACE_H */